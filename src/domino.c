@@ -1,5 +1,5 @@
 // domino.c
-#define _POSIX_C_SOURCE 199309L
+#define _GNU_SOURCE // pthread_setaffinity_np / CPU_SET
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -8,15 +8,70 @@
 #include <unistd.h>
 #include <stdbool.h>
 #include <ctype.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdatomic.h>
+#include <poll.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <stdint.h>
+#include <limits.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/resource.h>
+#include <sys/ioctl.h>
+#include <sys/mman.h>
+#include <ucontext.h>
+#include <sys/stat.h>
+#include <sched.h>
+#include <dirent.h>
+#include <signal.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
 
-#define MAX_PLAYERS 4
-#define MAX_TILES   28
+#define MAX_PLAYERS 10
+#define MAX_PIP     12
+#define MAX_TILES   ((MAX_PIP+1)*(MAX_PIP+2)/2) // 91 en doble-doce
+#define HISTORY_CAP 32   // anillo: el reporte solo muestra las últimas 16
+#define D6_STORAGE  84  // manos + pozo + tren de doble-seis en el peor reparto (2 jugadores)
 #define Q_DEFAULT_MS 50
+#define Q_MIN_MS 1
+#define Q_MAX_MS 1000
+#define Q_EWMA_ALPHA 0.25   // peso de la última ráfaga en la estimación
+#define Q_HEADROOM 1.5      // margen del cuantum sobre la ráfaga estimada
+#define Q_HIST_LEN 8
+#define YIELD_STALL_NS 1000000000L // jugada encolada sin aplicar: redespachar tras 1 s
+#define DASH_DEFAULT_RATE 8192 // bytes/s del panel
+#define DASH_ROW_LEN 160
+#define Q_DEFAULT_CAP 256
+#define MOVE_BATCH_MAX 32
 
 typedef enum { FCFS, SJF_PLAYERS, SJF_POINTS, RR } policy_t;
 typedef enum { NEW, READY, RUNNING, IO_WAIT, TERMINATED } pstate_t;
 
-typedef struct { int a, b; } tile_t;
+// Pips de 0..12 (o -1 en un pase): un byte cada uno alcanza para doble-doce.
+typedef struct { int8_t a, b; } tile_t;
+
+// Juego de fichas: doble-seis (28), doble-nueve (55) o doble-doce (91).
+typedef struct {
+    const char *name;
+    int max_pip;
+    int tiles;
+    int max_players;
+    int deal[MAX_PLAYERS+1]; // fichas repartidas según cantidad de jugadores
+} domino_set_t;
+
+static const domino_set_t DOMINO_SETS[] = {
+    { "doble-seis",  6, 28, 4,  { 0, 0, 7, 7, 7 } },
+    { "doble-nueve", 9, 55, 10, { 0, 0, 10, 10, 10, 8, 8, 7, 6, 6, 5 } },
+    { "doble-doce", 12, 91, 10, { 0, 0, 12, 12, 12, 11, 11, 10, 10, 9, 8 } },
+};
+#define DOMINO_SET_COUNT ((int)(sizeof(DOMINO_SETS)/sizeof(DOMINO_SETS[0])))
+
+typedef struct wheel_timer_t wheel_timer_t;
 
 typedef struct {
     int pid;
@@ -27,259 +82,1015 @@ typedef struct {
     pthread_mutex_t mtx;
     pthread_cond_t  run_cv;
     int can_run;
+    // Cuantum adaptativo: solo lo toca el planificador, salvo push_*.
+    int quantum_ms;                  // (mtx al escribir) lo lee el checkpoint
+    double burst_ewma_ms;            // (mtx al escribir) <0 = todavía sin ráfagas medidas
+    long burst_start_ns;             // primer despacho del turno en curso
+    int burst_open;
+    long push_ns;                    // (mtx) cuándo encoló el jugador su jugada...
+    uint32_t push_version;           // ...y para qué versión de la mesa la decidió
+    pthread_cond_t yield_cv;         // aviso de push: la porción termina antes del cuantum
+    int q_hist[Q_HIST_LEN]; int q_changes; // últimos cuantums asignados
+    wheel_timer_t *wheel;            // con --sched wheel: temporizador del planificador de la mesa
 } pcb_t;
 
 typedef struct {
-    int player_id, table_id;
+    int table_id;
+    uint8_t player_id;
+    int8_t side; // -1 izq, +1 der
     tile_t t;
-    int side; // -1 izq, +1 der
+    long push_ns, pop_ns; // marcas de latencia (0 = fuera de la cola)
 } move_t;
 
+// Entrada del historial: solo lo que se imprime, sin mesa ni marcas de tiempo.
+typedef struct {
+    tile_t t;
+    uint8_t player_id;
+    int8_t side;
+} hist_move_t;
+
 typedef struct table_runtime_t table_runtime_t;
+typedef struct table_metrics_t table_metrics_t;
 
+// Orden de locks (nunca tomar uno de la izquierda teniendo uno de la derecha):
+//   io_mtx -> g->mtx -> hand_mtx[i] (i ascendente) -> q_mtx
+// - g->mtx protege tren, extremos, turno, historial y fin de partida. Sólo lo
+//   toman el validador (apply_move) y el scheduler al saltar un asiento
+//   terminado; los lectores usan la vista publicada (load_view) o lo toman
+//   brevemente para copiar el tren.
+// - hand_mtx[i] protege hands[i]/hand_len[i]. El dueño del asiento sólo muta
+//   su propia mano (robos); el validador le quita la ficha jugada.
+// - El pozo no tiene lock: pool_top se decrementa atómicamente en cada robo.
+// - wheel.mtx (--sched wheel) es una hoja: nunca se toma otro lock con él, y
+//   los callbacks de la rueda corren sin tenerlo.
 typedef struct {
     // extremos, tren, manos, pozo...
-    tile_t train[64]; int train_len;
-    int left_end, right_end;
-    tile_t hands[MAX_PLAYERS][14]; int hand_len[MAX_PLAYERS];
-    tile_t pool[28]; int pool_len;
-    int turn, table_id, finished;
-    int player_count;
-    int human_player;
-    int winner;
-    int blocked;
-    int passes_in_row;
-    move_t history[256]; int history_len;
-    pthread_mutex_t mtx; // sección crítica del estado
+    // Tren, manos y pozo apuntan a un único bloque dimensionado según el juego:
+    // doble-seis usa small_store (sin salto al heap), los juegos mayores heap_store.
+    // Índices y contadores caben en un byte (a lo sumo 91 fichas y 10 jugadores).
+    const domino_set_t *set;
+    tile_t *train;
+    tile_t *hands[MAX_PLAYERS];
+    tile_t *pool; atomic_int pool_top; // puede quedar negativo: usar pool_count()
+    int table_id;
+    _Atomic uint64_t view; // extremos/turno/fin/versión empaquetados (publish_view)
+    long version; // +1 por cada jugada o pase aplicado
+    atomic_long applied_push_ns, applied_ns; // última jugada aplicada, para medir el despacho
+    table_metrics_t *metrics; // NULL en partidas sin hilos (benchmarks)
+    wheel_timer_t *sched_wheel; // con --sched wheel: el validador despierta al planificador
+    tile_t *heap_store; int heap_cap; int store_len;
+    uint8_t train_len, hand_cap;
+    uint8_t hand_len[MAX_PLAYERS];
+    int8_t left_end, right_end;
+    int8_t turn, finished;
+    int8_t player_count;
+    int8_t human_player;
+    int8_t winner;
+    int8_t blocked;
+    uint8_t passes_in_row;
+    uint32_t history_count; // jugadas registradas; el anillo guarda las últimas HISTORY_CAP
+    hist_move_t history[HISTORY_CAP];
+    tile_t small_store[D6_STORAGE];
+    pthread_mutex_t mtx; // tren y extremos (ver orden de locks arriba)
+    pthread_mutex_t hand_mtx[MAX_PLAYERS];
 } game_state_t;
 
+// Copia coherente de lo que los hilos consultan en cada iteración.
+typedef struct { int left, right, turn, finished; uint32_t version; } table_view_t;
+
+// Lo que ve una estrategia de bot al decidir, todo de solo lectura: su mano,
+// los extremos, el pozo y el historial público (anillo de HISTORY_CAP jugadas,
+// la última en (history_count-1) % HISTORY_CAP; NULL si no lo pidió).
+typedef struct {
+    const tile_t *hand; int hand_len;
+    int left, right;           // -1 = extremo libre
+    int pool;
+    int seat, player_count;
+    const hist_move_t *history; uint32_t history_count;
+    uint64_t *rng;             // propio del asiento, para decisiones aleatorias
+} bot_view_t;
+
+// Una estrategia elige una jugada legal: índice en la mano y lado (-1 izq,
+// +1 der), o -1 si no tiene ninguna (el bot roba o pasa).
+typedef struct {
+    const char *name;
+    int (*choose)(const bot_view_t *v, int *side);
+    int uses_history;          // copiar el historial (toma g->mtx) antes de decidir
+} bot_strategy_t;
+
 /* ===== Prototipos ===== */
 // Utilidades
-static void shuffle(tile_t *v, int n);
-static void build_shuffled_deck(tile_t *deck, int *out_len);
-static void setup_game_state(game_state_t *g, int table_id, int player_count, int human_player);
-static int  can_play(const game_state_t *g, int pid, tile_t *out, int *side);
+static uint64_t rng_seed(uint64_t seed);
+static uint64_t rng_next(uint64_t *state);
+static void shuffle(tile_t *v, int n, uint64_t *rng);
+static void build_shuffled_deck(const domino_set_t *set, tile_t *deck, int *out_len, uint64_t *rng);
+static const domino_set_t *find_domino_set(int max_pip);
+static int  set_deal(const domino_set_t *set, int player_count);
+static int  layout_game_storage(game_state_t *g, int player_count, int deal);
+static int  setup_game_state(game_state_t *g, const domino_set_t *set, int table_id, int player_count, int human_player, uint64_t *rng);
+static void release_game_state(game_state_t *g);
+static void init_game_locks(game_state_t *g);
+static void destroy_game_locks(game_state_t *g);
+static void publish_view(game_state_t *g);
+static table_view_t load_view(game_state_t *g);
+static int  pool_count(game_state_t *g);
+static int  can_play(game_state_t *g, int pid, tile_t *out, int *side);
 static int  draw_from_pool(game_state_t *g, int pid);
+static void apply_move(game_state_t *g, const move_t *mv);
 // Cola de movimientos (mutex + cond)
-static void moveq_init(void);
-static void moveq_push(const move_t *m);
-static int  moveq_pop_for_table(int table_id, move_t *out);
+static int  moveq_init(int capacity, int table_count);
+static void moveq_free(void);
+static int  moveq_push(const move_t *m);
+static int  moveq_try_push(const move_t *m);
+static void moveq_close_table(int table_id);
+static int  moveq_pop_batch_for_table(int table_id, move_t *out, int max);
+static int  moveq_pop_batch_timed(int table_id, move_t *out, int max, int wait_ms);
 // Validación (HVU)
 static void *validator_thread(void *arg);
 // Planificador (HPCS)
 static void *scheduler_thread(void *arg);
+static void wheel_kick(wheel_timer_t *t);
 // Mesa (HJ)
 static void *table_thread(void *arg);
 // Jugador
 static void *player_thread(void *arg);
 static void print_table_state(table_runtime_t *table, int force);
 static void *reporter_thread(void *arg);
+static void print_validator_summary(void);
+static void print_latency_report(void);
+// Servidor de sockets
+static void server_notify_table(int table_id);
 // Ayudas
 static long now_ms(void);
+static long now_ns(void);
 static void msleep(int ms);
 
+/* ===== Configuración ===== */
+typedef enum { TIMEOUT_PLAY, TIMEOUT_PASS } timeout_action_t;
+typedef enum { PIN_NONE, PIN_CORE, PIN_GROUP, PIN_NODE } pin_mode_t;
+typedef enum { QFULL_BLOCK, QFULL_FAIL } queue_full_t;
+typedef enum { EXEC_THREADS, EXEC_CORO } exec_mode_t;
+
+typedef struct {
+    const domino_set_t *set;
+    int players;      // 0 = aleatorio (2-4) por mesa
+    int bench_games;  // >0: medir coste por jugada de cada juego y salir
+    int turn_timeout_ms;            // 0 = el humano puede pensar sin límite
+    timeout_action_t timeout_action;
+    const char *serve_addr;         // --serve: "unix:/ruta" o "tcp:PUERTO"
+    int tables;                     // mesas en modo servidor
+    int remote_seats;               // asientos por mesa reservados a clientes
+    const char *client_addr;        // --client: generador de carga
+    int conns;
+    int duration_s;
+    const char *metrics_path;       // --metrics: archivo Prometheus o JSON
+    int metrics_json;
+    int quantum_ms;                 // cuantum Round-Robin inicial (y de referencia)
+    int quantum_min_ms, quantum_max_ms; // límites del cuantum adaptativo
+    pin_mode_t pin_mode;            // ubicación de los hilos de cada mesa
+    int pin_group;                  // núcleos por grupo con PIN_GROUP
+    int bench_affinity;             // comparar con y sin fijar hilos y salir
+    int bench_footprint;            // medir memoria por mesa con 1k y 100k mesas y salir
+    const char *checkpoint_path;    // --checkpoint: destino de SIGUSR2 / "ckpt"
+    int checkpoint_every_s;         // 0 = solo a pedido
+    const char *resume_path;        // --resume: reanudar mesas sin preguntas
+    const char *bench_checkpoint;   // --bench-checkpoint: medir guardar/restaurar --tables mesas
+    long analyze_games;             // --analyze: partidas del análisis de manos iniciales
+    const char *analyze_out;        // CSV del análisis
+    int analyze_threads;            // 0 = un hilo por CPU en línea
+    long seed;                      // semilla del análisis (-1 = según la hora)
+    const bot_strategy_t *bots[MAX_PLAYERS]; int bot_count; // --bots: estrategia por asiento (cíclica)
+    long bench_bots;                // --bench-bots: partidas del torneo de estrategias
+    int queue_cap;                  // jugadas pendientes máximas en la cola
+    queue_full_t queue_full;        // cola llena: esperar o rechazar
+    int dashboard;                  // panel ANSI en sitio en lugar del volcado completo
+    int dashboard_rate;             // bytes/s máximos del panel
+    exec_mode_t exec_mode;          // --exec: un hilo por asiento o corrutinas en un hilo por mesa
+    int bench_coro;                 // comparar ambos modos con --tables mesas y salir
+    int sched_wheel;                // --sched wheel: un hilo de temporizadores planifica todas las mesas
+    int sched_given;                // --sched explícito: --bench-wheel mide solo ese modelo
+    int bench_wheel;                // --bench-wheel: planificadores sintéticos del banco de la rueda
+} app_config_t;
+
+static app_config_t cfg = {
+    .set = &DOMINO_SETS[0], .players = 0, .bench_games = 0,
+    .turn_timeout_ms = 60000, .timeout_action = TIMEOUT_PLAY,
+    .tables = 1, .remote_seats = MAX_PLAYERS, .conns = 1, .duration_s = 60,
+    .analyze_out = "manos.csv", .seed = -1, .quantum_ms = Q_DEFAULT_MS, .quantum_min_ms = Q_MIN_MS, .quantum_max_ms = Q_MAX_MS, .pin_mode = PIN_NONE, .pin_group = 1,
+    .queue_cap = Q_DEFAULT_CAP, .queue_full = QFULL_BLOCK,
+    .dashboard_rate = DASH_DEFAULT_RATE,
+};
+
+/* ===== Métricas ===== */
+// Cada hilo escribe solo en su ranura (validador, planificador o asiento), en
+// su propia línea de caché y con atómicos relajados; el reporter suma las
+// ranuras al exportar. La profundidad de cola por mesa es encoladas - extraídas
+// - descartadas al cerrarse la mesa.
+typedef struct {
+    _Alignas(64) atomic_long moves_applied;
+    atomic_long passes, draws, pushes, pops;
+    atomic_long dispatches, games_finished, games_blocked;
+    atomic_long batches, lock_acquisitions, drops;
+    atomic_long idle_saved_us;   // planificador: cuantum de referencia - cuantum vencido
+} metrics_slot_t;
+
+// Histogramas de latencia con cubetas logarítmicas (estilo HDR): 2^LAT_SUB_BITS
+// subcubetas lineales por potencia de dos, error relativo < 12,5 %. Se escriben
+// con fetch_add relajado y se fusionan al imprimir. Son 5 KB por juego de
+// etapas, así que las mesas comparten LAT_STRIPES franjas (mesa % franjas) en
+// lugar de tener uno propio cada una.
+#define LAT_SUB_BITS 3
+#define LAT_SUB (1 << LAT_SUB_BITS)
+#define LAT_BUCKETS (40 * LAT_SUB) // hasta ~2^40 ns (18 minutos)
+#define LAT_STRIPES 64
+typedef enum { LAT_QUEUE, LAT_VALIDATE, LAT_DISPATCH, LAT_TOTAL, LAT_STAGES } lat_stage_t;
+static const char *const LAT_STAGE_NAMES[LAT_STAGES] = {
+    "cola (push→pop)", "validación (pop→aplicada)", "despacho (aplicada→siguiente)", "total (push→siguiente)",
+};
+typedef struct { _Alignas(64) atomic_uint bucket[LAT_BUCKETS]; } lat_hist_t;
+
+struct table_metrics_t {
+    metrics_slot_t validator;
+    metrics_slot_t scheduler;
+    metrics_slot_t seat[MAX_PLAYERS];
+    lat_hist_t *lat; // [LAT_STAGES] de la franja de la mesa
+};
+
+static table_metrics_t *metrics_tables; static int metrics_table_count;
+static lat_hist_t *lat_stripes; static int lat_stripe_count;
+
+#define METRIC_ADD(m, slot, field, n) do{ \
+        if(m) atomic_fetch_add_explicit(&(m)->slot.field, (n), memory_order_relaxed); \
+    }while(0)
+#define METRIC_INC(m, slot, field) METRIC_ADD(m, slot, field, 1)
+
+static int lat_bucket(long ns){
+    if(ns < LAT_SUB) return ns > 0 ? (int)ns : 0;
+    int msb = 63 - __builtin_clzl((unsigned long)ns);
+    int shift = msb - LAT_SUB_BITS;
+    int idx = ((shift + 1) << LAT_SUB_BITS) + (int)((ns >> shift) & (LAT_SUB - 1));
+    return idx < LAT_BUCKETS ? idx : LAT_BUCKETS - 1;
+}
+// Límite superior de la cubeta, lo que se informa como percentil.
+static long lat_bucket_high(int idx){
+    if(idx < LAT_SUB) return idx;
+    int shift = (idx >> LAT_SUB_BITS) - 1;
+    long mant = (idx & (LAT_SUB - 1)) + LAT_SUB;
+    return ((mant + 1) << shift) - 1;
+}
+#define LAT_RECORD(m, stage, ns) do{ \
+        if(m) atomic_fetch_add_explicit(&(m)->lat[stage].bucket[lat_bucket(ns)], 1, memory_order_relaxed); \
+    }while(0)
+
+static int metrics_init(int table_count){
+    size_t bytes = sizeof(table_metrics_t)*(size_t)table_count;
+    lat_stripe_count = table_count < LAT_STRIPES ? table_count : LAT_STRIPES;
+    size_t lat_bytes = sizeof(lat_hist_t)*LAT_STAGES*(size_t)lat_stripe_count;
+    metrics_tables = aligned_alloc(64, bytes);
+    lat_stripes = aligned_alloc(64, lat_bytes);
+    if(!metrics_tables || !lat_stripes){
+        free(metrics_tables); free(lat_stripes);
+        metrics_tables = NULL; lat_stripes = NULL;
+        return 0;
+    }
+    memset(metrics_tables, 0, bytes);
+    memset(lat_stripes, 0, lat_bytes);
+    for(int t=0;t<table_count;t++){
+        metrics_tables[t].lat = &lat_stripes[(t % lat_stripe_count)*LAT_STAGES];
+    }
+    metrics_table_count = table_count;
+    return 1;
+}
+
+static void metrics_free(void){
+    free(metrics_tables);
+    free(lat_stripes);
+    metrics_tables = NULL;
+    lat_stripes = NULL;
+    metrics_table_count = 0;
+    lat_stripe_count = 0;
+}
+
 /* ===== Cola de movimientos ===== */
+// Anillo acotado de cfg.queue_cap jugadas compartido por todas las mesas. Con la
+// cola llena el productor espera en q_space_cv (QFULL_BLOCK) o recibe 0
+// (QFULL_FAIL); ambos casos quedan contados en q_stats para el informe final.
 static pthread_mutex_t q_mtx = PTHREAD_MUTEX_INITIALIZER;
 static pthread_cond_t  q_cv  = PTHREAD_COND_INITIALIZER;
-static move_t qbuf[256]; static int qh=0, qt=0, qn=0;
+static pthread_cond_t  q_space_cv = PTHREAD_COND_INITIALIZER;
+static move_t *qbuf; static int qcap=0, qh=0, qt=0, qn=0;
+static unsigned char *q_closed; static int q_tables=0; // mesas terminadas: se descartan sus jugadas
+static struct {
+    int high_water;
+    long pushes, blocked_pushes, blocked_ns, rejected, dropped;
+} q_stats;
 static pthread_mutex_t io_mtx = PTHREAD_MUTEX_INITIALIZER;
 
-static void moveq_init(void){ qh=qt=qn=0; }
-static void moveq_push(const move_t *m){
+static int moveq_init(int capacity, int table_count){
+    moveq_free();
+    qbuf = malloc(sizeof(move_t)*(size_t)capacity);
+    q_closed = calloc(table_count > 0 ? table_count : 1, 1);
+    if(!qbuf || !q_closed){
+        moveq_free();
+        return 0;
+    }
+    qcap = capacity;
+    q_tables = table_count;
+    qh=qt=qn=0;
+    memset(&q_stats, 0, sizeof(q_stats));
+    return 1;
+}
+static void moveq_free(void){
+    free(qbuf); qbuf = NULL;
+    free(q_closed); q_closed = NULL;
+    qcap = q_tables = 0;
+}
+// Con la cola llena: esperar lugar, rechazar, o devolver 0 sin contarlo como
+// rechazo porque quien llama reintenta por su cuenta (y anota la espera).
+typedef enum { QPUSH_WAIT, QPUSH_TRY, QPUSH_POLL } qpush_t;
+
+// Devuelve 0 si la jugada no entró por cola llena (nunca con QPUSH_WAIT).
+static int moveq_push_mode(const move_t *m, qpush_t mode){
+    int closable = (m->table_id >= 0 && m->table_id < q_tables);
+    long t0 = 0;
     pthread_mutex_lock(&q_mtx);
-    qbuf[qt] = *m; qt = (qt+1)%256; qn++;
+    for(;;){
+        if(closable && q_closed[m->table_id]){
+            // La partida ya terminó y su validador no volverá a extraer.
+            q_stats.dropped++;
+            pthread_mutex_unlock(&q_mtx);
+            return 1;
+        }
+        if(qn < qcap) break;
+        if(mode != QPUSH_WAIT){
+            if(mode == QPUSH_TRY) q_stats.rejected++;
+            pthread_mutex_unlock(&q_mtx);
+            return 0;
+        }
+        if(t0 == 0){
+            t0 = now_ns();
+            q_stats.blocked_pushes++;
+        }
+        pthread_cond_wait(&q_space_cv, &q_mtx);
+    }
+    if(t0) q_stats.blocked_ns += now_ns() - t0;
+    qbuf[qt] = *m; qbuf[qt].push_ns = now_ns();
+    qt = (qt+1)%qcap; qn++;
+    q_stats.pushes++;
+    if(qn > q_stats.high_water) q_stats.high_water = qn;
     pthread_cond_broadcast(&q_cv);
     pthread_mutex_unlock(&q_mtx);
+    if(m->table_id >= 0 && m->table_id < metrics_table_count){
+        METRIC_INC(&metrics_tables[m->table_id], seat[m->player_id], pushes);
+    }
+    return 1;
 }
-static int moveq_pop_for_table(int table_id, move_t *out){
+// Con la política de --queue-full: 0 solo si se rechazó (QFULL_FAIL).
+static int moveq_push(const move_t *m){
+    return moveq_push_mode(m, cfg.queue_full == QFULL_BLOCK ? QPUSH_WAIT : QPUSH_TRY);
+}
+// Nunca espera, sea cual sea --queue-full: para el hilo epoll del servidor,
+// que atiende a todas las conexiones.
+static int moveq_try_push(const move_t *m){
+    return moveq_push_mode(m, QPUSH_TRY);
+}
+// Anota en q_stats una espera por cola llena hecha fuera de q_space_cv.
+static void moveq_note_wait(long ns){
     pthread_mutex_lock(&q_mtx);
-    for(;;){
-        while(qn==0) pthread_cond_wait(&q_cv, &q_mtx);
-        int found = -1;
-        for(int i=0;i<qn;i++){
-            int pos = (qh + i) % 256;
-            if(qbuf[pos].table_id == table_id){
-                found = pos;
-                break;
+    q_stats.blocked_pushes++;
+    q_stats.blocked_ns += ns;
+    pthread_mutex_unlock(&q_mtx);
+}
+// Extrae en orden hasta max jugadas de la mesa (las descarta si out es NULL) y
+// compacta el resto en una sola pasada. Llamar con q_mtx tomado.
+static int moveq_take_locked(int table_id, move_t *out, int max){
+    int taken = 0, kept = 0;
+    long t = out ? now_ns() : 0;
+    for(int i=0;i<qn;i++){
+        int pos = (qh + i) % qcap;
+        if(qbuf[pos].table_id == table_id && taken < max){
+            if(out){
+                out[taken] = qbuf[pos];
+                out[taken].pop_ns = t;
             }
+            taken++;
+        }else{
+            if(taken > 0) qbuf[(qh + kept) % qcap] = qbuf[pos];
+            kept++;
         }
-        if(found >= 0){
-            *out = qbuf[found];
-            int last_pos = (qh + qn - 1) % 256;
-            while(found != last_pos){
-                int next = (found + 1) % 256;
-                qbuf[found] = qbuf[next];
-                found = next;
-            }
-            qt = (qt + 255) % 256;
-            qn--;
+    }
+    if(taken > 0){
+        qn = kept;
+        qt = (qh + qn) % qcap;
+        pthread_cond_broadcast(&q_space_cv);
+    }
+    return taken;
+}
+// Extrae en orden todas las jugadas pendientes de la mesa (hasta max) con una
+// sola toma de q_mtx y compacta el resto de la cola. Bloquea si no hay ninguna.
+static int moveq_pop_batch_for_table(int table_id, move_t *out, int max){
+    pthread_mutex_lock(&q_mtx);
+    for(;;){
+        while(qn==0) pthread_cond_wait(&q_cv, &q_mtx);
+        int taken = moveq_take_locked(table_id, out, max);
+        if(taken > 0){
             pthread_mutex_unlock(&q_mtx);
-            return 1;
+            return taken;
         }
         pthread_cond_wait(&q_cv, &q_mtx);
     }
+}
+// Como la anterior, pero espera a lo sumo wait_ms (0 = no espera) y puede
+// devolver 0. q_cv usa el reloj por defecto, de ahí el plazo en CLOCK_REALTIME.
+static int moveq_pop_batch_timed(int table_id, move_t *out, int max, int wait_ms){
+    struct timespec ts; clock_gettime(CLOCK_REALTIME, &ts);
+    ts.tv_sec  += wait_ms / 1000;
+    ts.tv_nsec += (wait_ms % 1000) * 1000000L;
+    if(ts.tv_nsec >= 1000000000L){ ts.tv_sec++; ts.tv_nsec -= 1000000000L; }
+    pthread_mutex_lock(&q_mtx);
+    int taken;
+    while((taken = moveq_take_locked(table_id, out, max)) == 0 && wait_ms > 0){
+        if(pthread_cond_timedwait(&q_cv, &q_mtx, &ts) == ETIMEDOUT){
+            taken = moveq_take_locked(table_id, out, max);
+            break;
+        }
+    }
     pthread_mutex_unlock(&q_mtx);
-    return 0;
+    return taken;
+}
+// El validador de una mesa terminada libera su espacio en la cola: las jugadas
+// rezagadas (p. ej. la automática de un asiento remoto) no ocupan capacidad.
+static void moveq_close_table(int table_id){
+    pthread_mutex_lock(&q_mtx);
+    if(table_id >= 0 && table_id < q_tables){
+        q_closed[table_id] = 1;
+        int dropped = moveq_take_locked(table_id, NULL, qcap);
+        q_stats.dropped += dropped;
+        // Lo llama el validador de la mesa: su ranura, como pops.
+        if(table_id < metrics_table_count) METRIC_ADD(&metrics_tables[table_id], validator, drops, dropped);
+        pthread_cond_broadcast(&q_space_cv); // despierta a quien espere por esta mesa
+    }
+    pthread_mutex_unlock(&q_mtx);
+}
+
+static void print_queue_summary(void){
+    pthread_mutex_lock(&q_mtx);
+    printf("Cola: capacidad %d, máximo ocupado %d, %ld jugadas encoladas, %ld esperas por cola llena (%.1f ms), %ld rechazadas, %ld descartadas de mesas terminadas\n",
+           qcap, q_stats.high_water, q_stats.pushes, q_stats.blocked_pushes, q_stats.blocked_ns/1e6,
+           q_stats.rejected, q_stats.dropped);
+    pthread_mutex_unlock(&q_mtx);
+}
+
+/* ===== Entrada humana (stdin multiplexado) ===== */
+// Solo input_thread lee stdin mientras hay partidas en curso (main lo usa
+// durante la configuración). Cada línea se entrega al buzón del humano que
+// espera turno, así nadie bloquea en stdin con io_mtx tomado.
+#define LINE_LEN    64
+#define INBOX_LINES 8
+
+typedef struct {
+    pthread_mutex_t mtx;
+    pthread_cond_t  cv;   // CLOCK_MONOTONIC
+    char lines[INBOX_LINES][LINE_LEN]; int head, count;
+    int waiting;          // el humano tiene el turno y acepta comandos
+    long wait_seq;        // orden de espera para líneas sin prefijo de mesa
+} human_inbox_t;
+
+static struct { char buf[1024]; size_t len; int eof; } in_rd;
+static atomic_int  input_closed;
+static atomic_long input_wait_seq;
+
+static void inbox_init(human_inbox_t *in){
+    pthread_condattr_t attr;
+    pthread_condattr_init(&attr);
+    pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+    pthread_mutex_init(&in->mtx, NULL);
+    pthread_cond_init(&in->cv, &attr);
+    pthread_condattr_destroy(&attr);
+    in->head = in->count = 0;
+    in->waiting = 0;
+}
+
+static void inbox_destroy(human_inbox_t *in){
+    pthread_mutex_destroy(&in->mtx);
+    pthread_cond_destroy(&in->cv);
+}
+
+// Espera con timeout relativo sobre una condición inicializada con CLOCK_MONOTONIC.
+static void cond_wait_ms(pthread_cond_t *cv, pthread_mutex_t *mtx, long ms){
+    struct timespec ts; clock_gettime(CLOCK_MONOTONIC, &ts);
+    ts.tv_sec  += ms / 1000;
+    ts.tv_nsec += (ms % 1000) * 1000000L;
+    if(ts.tv_nsec >= 1000000000L){ ts.tv_sec++; ts.tv_nsec -= 1000000000L; }
+    pthread_cond_timedwait(cv, mtx, &ts);
+}
+
+// Devuelve 1 si hay datos nuevos, 0 si venció el timeout y -1 en EOF.
+static int input_fill(int timeout_ms){
+    if(in_rd.eof) return -1;
+    struct pollfd pfd = { .fd = STDIN_FILENO, .events = POLLIN };
+    if(poll(&pfd, 1, timeout_ms) <= 0) return 0;
+    if(in_rd.len >= sizeof(in_rd.buf)) in_rd.len = 0; // línea absurda: se descarta
+    ssize_t n = read(STDIN_FILENO, in_rd.buf + in_rd.len, sizeof(in_rd.buf) - in_rd.len);
+    if(n <= 0){
+        in_rd.eof = 1;
+        return -1;
+    }
+    in_rd.len += (size_t)n;
+    return 1;
+}
+
+static int input_take_line(char *out, size_t n){
+    char *nl = memchr(in_rd.buf, '\n', in_rd.len);
+    if(!nl && !(in_rd.eof && in_rd.len > 0)) return 0;
+    size_t line_len = nl ? (size_t)(nl - in_rd.buf) : in_rd.len;
+    size_t consumed = nl ? line_len + 1 : line_len;
+    size_t copy = line_len < n-1 ? line_len : n-1;
+    memcpy(out, in_rd.buf, copy);
+    out[copy] = '\0';
+    memmove(in_rd.buf, in_rd.buf + consumed, in_rd.len - consumed);
+    in_rd.len -= consumed;
+    return 1;
+}
+
+// Lectura bloqueante para main (sin hilo de entrada activo). 0 en EOF.
+static int read_line(char *out, size_t n){
+    for(;;){
+        if(input_take_line(out, n)) return 1;
+        if(input_fill(-1) < 0 && !input_take_line(out, n)) return 0;
+    }
+}
+
+// Marca el inicio/fin del turno humano; fuera de él el enrutador descarta líneas.
+static void inbox_set_waiting(human_inbox_t *in, int waiting){
+    pthread_mutex_lock(&in->mtx);
+    in->waiting = waiting;
+    in->head = in->count = 0;
+    if(waiting) in->wait_seq = atomic_fetch_add(&input_wait_seq, 1);
+    pthread_mutex_unlock(&in->mtx);
+}
+
+// El humano espera su próxima línea hasta deadline_ms (-1 = sin límite).
+// Devuelve 0 si venció el plazo o stdin se cerró.
+static int inbox_wait_line(human_inbox_t *in, long deadline_ms, char *out, size_t n){
+    int got = 0;
+    pthread_mutex_lock(&in->mtx);
+    while(1){
+        if(in->count > 0){
+            snprintf(out, n, "%s", in->lines[in->head]);
+            in->head = (in->head + 1) % INBOX_LINES;
+            in->count--;
+            got = 1;
+            break;
+        }
+        if(atomic_load(&input_closed)) break;
+        long wait = 200;
+        if(deadline_ms >= 0){
+            long left = deadline_ms - now_ms();
+            if(left <= 0) break;
+            if(left < wait) wait = left;
+        }
+        cond_wait_ms(&in->cv, &in->mtx, wait);
+    }
+    pthread_mutex_unlock(&in->mtx);
+    return got;
+}
+
+static void io_printf(const char *fmt, ...){
+    va_list ap;
+    va_start(ap, fmt);
+    pthread_mutex_lock(&io_mtx);
+    vprintf(fmt, ap);
+    fflush(stdout);
+    pthread_mutex_unlock(&io_mtx);
+    va_end(ap);
 }
 
 /* ===== Validator (HVU) ===== */
-static int compute_hand_points(const game_state_t *g, int pid){
+static int compute_hand_points(game_state_t *g, int pid){
     int sum = 0;
+    pthread_mutex_lock(&g->hand_mtx[pid]);
     for(int i=0;i<g->hand_len[pid];++i){
         tile_t t = g->hands[pid][i];
         sum += t.a + t.b;
     }
+    pthread_mutex_unlock(&g->hand_mtx[pid]);
     return sum;
 }
 
 static int next_active_player(const game_state_t *g, int current){
     if(g->player_count <= 0) return -1;
-    for(int i=1;i<=g->player_count;i++){
-        int idx = (current + i) % g->player_count;
-        if(g->hand_len[idx] >= 0){
-            return idx;
-        }
-    }
-    return current;
+    // Todos los asientos siguen activos hasta el fin de la partida.
+    return (current + 1) % g->player_count;
 }
 
 static void append_history(game_state_t *g, const move_t *mv){
-    if(g->history_len >= 256) return;
-    g->history[g->history_len++] = *mv;
+    g->history[g->history_count % HISTORY_CAP] = (hist_move_t){ .t = mv->t, .player_id = mv->player_id, .side = mv->side };
+    g->history_count++;
 }
 
 static void finish_round(game_state_t *g, int winner, int blocked){
+    METRIC_INC(g->metrics, validator, games_finished);
+    if(blocked) METRIC_INC(g->metrics, validator, games_blocked);
     g->finished = 1;
     g->winner = winner;
     g->blocked = blocked;
     g->turn = -1;
 }
 
-static void *validator_thread(void *arg){
-    game_state_t *g = (game_state_t*)arg;
-    while(!g->finished){
-        move_t mv; moveq_pop_for_table(g->table_id, &mv);
-        pthread_mutex_lock(&g->mtx);
-        if(g->finished){
-            pthread_mutex_unlock(&g->mtx);
-            break;
-        }
+// Aplica una jugada (o pase) ya desencolada sobre el estado. Llamar con g->mtx
+// tomado; la mano del jugador se toca sólo bajo su hand_mtx.
+static void apply_move(game_state_t *g, const move_t *m){
+    move_t mv = *m;
+    int pid = mv.player_id;
 
-        if(mv.player_id < 0 || mv.player_id >= g->player_count){
-            pthread_mutex_unlock(&g->mtx);
-            continue;
+    if(mv.side == 0){
+        move_t logged = mv;
+        logged.t = (tile_t){ .a=-1, .b=-1 };
+        g->passes_in_row++;
+        append_history(g, &logged);
+        METRIC_INC(g->metrics, validator, passes);
+    }else{
+        int target = (mv.side < 0) ? g->left_end : g->right_end;
+        int idx = -1;
+        tile_t tile = mv.t;
+        int hand_locked = 1;
+        pthread_mutex_lock(&g->hand_mtx[pid]);
+        for(int i=0;i<g->hand_len[pid];++i){
+            tile_t cur = g->hands[pid][i];
+            if((cur.a == tile.a && cur.b == tile.b) || (cur.a == tile.b && cur.b == tile.a)){
+                idx = i;
+                tile = cur;
+                break;
+            }
         }
-
-        int pid = mv.player_id;
-
-        if(mv.side == 0){
-            move_t logged = mv;
-            logged.t = (tile_t){ .a=-1, .b=-1 };
-            g->passes_in_row++;
-            append_history(g, &logged);
-        }else{
-            int target = (mv.side < 0) ? g->left_end : g->right_end;
-            int idx = -1;
-            tile_t tile = mv.t;
-            for(int i=0;i<g->hand_len[pid];++i){
-                tile_t cur = g->hands[pid][i];
-                if((cur.a == tile.a && cur.b == tile.b) || (cur.a == tile.b && cur.b == tile.a)){
-                    idx = i;
-                    tile = cur;
-                    break;
+        if(idx >= 0){
+            tile_t placed = tile;
+            int valid = 0;
+            if(g->train_len == 0){
+                valid = 1;
+            }else if(mv.side < 0){
+                if(target == -1 || tile.b == target){
+                    valid = 1;
+                    placed = tile;
+                }else if(tile.a == target){
+                    valid = 1;
+                    placed = (tile_t){ tile.b, tile.a };
                 }
-            }
-            if(idx >= 0){
-                tile_t placed = tile;
-                int valid = 0;
-                if(g->train_len == 0){
+            }else{
+                if(target == -1 || tile.a == target){
                     valid = 1;
-                }else if(mv.side < 0){
-                    if(target == -1 || tile.b == target){
-                        valid = 1;
-                        placed = tile;
-                    }else if(tile.a == target){
-                        valid = 1;
-                        placed = (tile_t){ tile.b, tile.a };
-                    }
-                }else{
-                    if(target == -1 || tile.a == target){
-                        valid = 1;
-                        placed = tile;
-                    }else if(tile.b == target){
-                        valid = 1;
-                        placed = (tile_t){ tile.b, tile.a };
-                    }
+                    placed = tile;
+                }else if(tile.b == target){
+                    valid = 1;
+                    placed = (tile_t){ tile.b, tile.a };
                 }
+            }
 
-                if(valid){
-                    if(mv.side < 0){
-                        int len = g->train_len;
-                        if(len > 63) len = 63;
-                        if(len > 0){
-                            memmove(&g->train[1], &g->train[0], sizeof(tile_t)*len);
-                        }
-                        g->train[0] = placed;
-                        g->left_end = placed.a;
-                        if(g->train_len == 0){
-                            g->right_end = placed.b;
-                        }
-                        if(g->train_len < 64) g->train_len = (len < 64 ? len + 1 : 64);
-                    }else{
-                        if(g->train_len < 64){
-                            g->train[g->train_len] = placed;
-                        }
+            if(valid){
+                // El tren tiene capacidad para todas las fichas del juego.
+                if(mv.side < 0){
+                    if(g->train_len > 0){
+                        memmove(&g->train[1], &g->train[0], sizeof(tile_t)*g->train_len);
+                    }
+                    g->train[0] = placed;
+                    g->left_end = placed.a;
+                    if(g->train_len == 0){
                         g->right_end = placed.b;
-                        if(g->train_len == 0){
-                            g->left_end = placed.a;
-                        }
-                        if(g->train_len < 64) g->train_len++;
                     }
-
-                    for(int j=idx;j<g->hand_len[pid]-1;++j){
-                        g->hands[pid][j] = g->hands[pid][j+1];
+                }else{
+                    g->train[g->train_len] = placed;
+                    g->right_end = placed.b;
+                    if(g->train_len == 0){
+                        g->left_end = placed.a;
                     }
-                    if(g->hand_len[pid] > 0) g->hand_len[pid]--;
+                }
+                g->train_len++;
+
+                for(int j=idx;j<g->hand_len[pid]-1;++j){
+                    g->hands[pid][j] = g->hands[pid][j+1];
+                }
+                if(g->hand_len[pid] > 0) g->hand_len[pid]--;
+                int emptied = (g->hand_len[pid] == 0);
+                pthread_mutex_unlock(&g->hand_mtx[pid]);
+                hand_locked = 0;
 
-                    move_t logged = mv;
-                    logged.t = placed;
-                    append_history(g, &logged);
-                    g->passes_in_row = 0;
+                move_t logged = mv;
+                logged.t = placed;
+                append_history(g, &logged);
+                g->passes_in_row = 0;
+                METRIC_INC(g->metrics, validator, moves_applied);
 
-                    if(g->hand_len[pid] == 0){
-                        finish_round(g, pid, 0);
-                    }
+                if(emptied){
+                    finish_round(g, pid, 0);
                 }
             }
         }
+        if(hand_locked) pthread_mutex_unlock(&g->hand_mtx[pid]);
+    }
 
-        if(!g->finished){
-            if(g->passes_in_row >= g->player_count){
-                int best_pid = -1;
-                int best_score = 1<<30;
-                for(int i=0;i<g->player_count;++i){
-                    int sc = compute_hand_points(g, i);
-                    if(sc < best_score){
-                        best_score = sc;
-                        best_pid = i;
-                    }
+    if(!g->finished){
+        if(g->passes_in_row >= g->player_count){
+            int best_pid = -1;
+            int best_score = 1<<30;
+            for(int i=0;i<g->player_count;++i){
+                int sc = compute_hand_points(g, i);
+                if(sc < best_score){
+                    best_score = sc;
+                    best_pid = i;
                 }
-                finish_round(g, best_pid, 1);
             }
+            finish_round(g, best_pid, 1);
         }
+    }
+
+    if(!g->finished){
+        int next = next_active_player(g, pid);
+        g->turn = next;
+    }
+    g->version++;
+    if(mv.push_ns){
+        // Antes de publicar la vista: quien vea la nueva versión lee estas marcas.
+        long applied = now_ns();
+        LAT_RECORD(g->metrics, LAT_QUEUE, mv.pop_ns - mv.push_ns);
+        LAT_RECORD(g->metrics, LAT_VALIDATE, applied - mv.pop_ns);
+        atomic_store_explicit(&g->applied_push_ns, mv.push_ns, memory_order_relaxed);
+        atomic_store_explicit(&g->applied_ns, applied, memory_order_relaxed);
+    }
+    publish_view(g);
+}
 
-        if(!g->finished){
-            int next = next_active_player(g, pid);
-            g->turn = next;
+// Todas las jugadas extraídas de la mesa se aplican en orden bajo una sola
+// toma de g->mtx; el turno se revisa jugada a jugada. Devuelve las aplicadas.
+static int validator_apply_batch(game_state_t *g, const move_t *batch, int n){
+    METRIC_ADD(g->metrics, validator, pops, n);
+    METRIC_INC(g->metrics, validator, batches);
+    int applied = 0;
+    pthread_mutex_lock(&g->mtx);
+    METRIC_INC(g->metrics, validator, lock_acquisitions);
+    for(int i=0;i<n && !g->finished;i++){
+        const move_t *mv = &batch[i];
+        // Una jugada fuera de turno (p. ej. la automática de un asiento remoto
+        // que llegó tras la del cliente) se descarta.
+        if(mv->player_id >= g->player_count || mv->player_id != g->turn){
+            continue;
         }
+        apply_move(g, mv);
+        applied++;
+    }
+    pthread_mutex_unlock(&g->mtx);
+    if(applied) server_notify_table(g->table_id);
+    if(applied && g->sched_wheel) wheel_kick(g->sched_wheel);
+    return applied;
+}
 
-        pthread_mutex_unlock(&g->mtx);
+static void *validator_thread(void *arg){
+    game_state_t *g = (game_state_t*)arg;
+    move_t batch[MOVE_BATCH_MAX];
+    while(!g->finished){
+        int n = moveq_pop_batch_for_table(g->table_id, batch, MOVE_BATCH_MAX);
+        validator_apply_batch(g, batch, n);
+    }
+    moveq_close_table(g->table_id);
+    return NULL;
+}
+
+/* ===== Rueda de temporizadores (--sched wheel) ===== */
+// Un solo hilo vence los cuantums y reintentos de los planificadores de todas
+// las mesas. Rueda jerárquica de WHEEL_LEVELS niveles de WHEEL_SLOTS ranuras con
+// tics de 250 us: el nivel k guarda lo que vence dentro de 64^(k+1) tics y se
+// derrama al nivel inferior cuando el tic alcanza su ranura. Cada ranura es una
+// lista intrusiva doblemente enlazada: armar y cancelar son O(1).
+#define WHEEL_BITS 6
+#define WHEEL_SLOTS (1 << WHEEL_BITS)
+#define WHEEL_LEVELS 4 // 2^24 tics: ~70 minutos
+#define WHEEL_TICK_NS 250000L // un vencimiento llega a lo sumo un tic tarde
+
+typedef enum { WT_IDLE, WT_QUEUED, WT_READY, WT_RUNNING, WT_DONE } wheel_state_t;
+
+struct wheel_timer_t {
+    wheel_timer_t *prev, *next;
+    uint64_t expires;              // tic de vencimiento
+    long due_ns;                   // instante pedido, para medir el retraso
+    // Devuelve en cuántos ms rearmarse, o <0 para terminar. late_ns es el
+    // retraso sobre due_ns, o -1 si lo adelantó wheel_kick.
+    int (*fn)(void *arg, long late_ns);
+    void *arg;
+    wheel_state_t state;           // (wheel.mtx)
+    int kicked;                    // wheel_kick mientras corría fn
+};
+
+static struct {
+    pthread_mutex_t mtx;
+    pthread_cond_t cv;             // CLOCK_MONOTONIC: despierta al hilo de la rueda
+    pthread_cond_t done_cv;        // algún temporizador pasó a WT_DONE
+    long base_ns;                  // instante del tic 0
+    uint64_t tick;                 // próximo tic a procesar
+    uint64_t sleep_until;          // tic hasta el que duerme el hilo (0 = despierto)
+    long armed;                    // temporizadores en ranuras
+    wheel_timer_t slot[WHEEL_LEVELS][WHEEL_SLOTS]; // centinelas
+    wheel_timer_t ready;           // adelantados: corren sin esperar al tic
+} wheel;
+static pthread_once_t wheel_once = PTHREAD_ONCE_INIT;
+
+// Despertares del planificador y retraso de sus temporizadores sobre el plazo
+// pedido, con la rueda o con un hilo por mesa; los compara --bench-wheel.
+static atomic_long sched_wakeups;
+static lat_hist_t sched_timer_lat;
+
+static void sched_timer_record(long late_ns){
+    atomic_fetch_add_explicit(&sched_timer_lat.bucket[lat_bucket(late_ns)], 1, memory_order_relaxed);
+}
+
+static void wheel_list_init(wheel_timer_t *h){ h->prev = h->next = h; }
+
+static void wheel_unlink(wheel_timer_t *t){
+    t->prev->next = t->next;
+    t->next->prev = t->prev;
+    t->prev = t->next = NULL;
+}
+
+static void wheel_append(wheel_timer_t *h, wheel_timer_t *t){
+    t->prev = h->prev;
+    t->next = h;
+    h->prev->next = t;
+    h->prev = t;
+}
+
+// Pasa toda la lista src al final de dst.
+static void wheel_splice(wheel_timer_t *dst, wheel_timer_t *src){
+    if(src->next == src) return;
+    src->next->prev = dst->prev;
+    dst->prev->next = src->next;
+    src->prev->next = dst;
+    dst->prev = src->prev;
+    wheel_list_init(src);
+}
+
+// Ubica t en la ranura que le toca según cuántos tics le faltan (wheel.mtx).
+static void wheel_place_locked(wheel_timer_t *t){
+    const uint64_t span = 1ULL << (WHEEL_BITS*WHEEL_LEVELS);
+    if(t->expires < wheel.tick) t->expires = wheel.tick;
+    if(t->expires - wheel.tick >= span) t->expires = wheel.tick + span - 1;
+    uint64_t delta = t->expires - wheel.tick;
+    int level = 0;
+    while(level < WHEEL_LEVELS-1 && delta >= (1ULL << (WHEEL_BITS*(level+1)))) level++;
+    wheel_append(&wheel.slot[level][(t->expires >> (WHEEL_BITS*level)) & (WHEEL_SLOTS-1)], t);
+    t->state = WT_QUEUED;
+}
+
+static void wheel_arm_locked(wheel_timer_t *t, int ms){
+    t->due_ns = now_ns() + (long)ms * 1000000L;
+    t->expires = (uint64_t)((t->due_ns - wheel.base_ns + WHEEL_TICK_NS - 1) / WHEEL_TICK_NS);
+    wheel_place_locked(t);
+    wheel.armed++;
+    if(wheel.sleep_until && t->expires < wheel.sleep_until) pthread_cond_signal(&wheel.cv);
+}
+
+// Procesa el tic wheel.tick: derrama los niveles cuya ranura empieza en él y
+// pasa a due lo que vence ahora.
+static void wheel_advance_locked(wheel_timer_t *due){
+    uint64_t now = wheel.tick;
+    for(int level=1;level<WHEEL_LEVELS;level++){
+        if(now & ((1ULL << (WHEEL_BITS*level)) - 1)) break;
+        wheel_timer_t moved; wheel_list_init(&moved);
+        wheel_splice(&moved, &wheel.slot[level][(now >> (WHEEL_BITS*level)) & (WHEEL_SLOTS-1)]);
+        while(moved.next != &moved){
+            wheel_timer_t *t = moved.next;
+            wheel_unlink(t);
+            wheel_place_locked(t);
+        }
+    }
+    wheel_splice(due, &wheel.slot[0][now & (WHEEL_SLOTS-1)]);
+    wheel.tick++;
+}
+
+// Próximo tic con algo en el nivel 0, sin pasar del próximo derrame del nivel 1
+// (que puede ser el mismo wheel.tick: sus ranuras aún no bajaron).
+static uint64_t wheel_next_tick_locked(void){
+    uint64_t limit = (wheel.tick + WHEEL_SLOTS - 1) & ~(uint64_t)(WHEEL_SLOTS - 1);
+    for(uint64_t t = wheel.tick; t < limit; t++){
+        const wheel_timer_t *h = &wheel.slot[0][t & (WHEEL_SLOTS-1)];
+        if(h->next != h) return t;
+    }
+    return limit;
+}
+
+static void *wheel_thread(void *arg){
+    (void)arg;
+    wheel_timer_t due; wheel_list_init(&due);
+    pthread_mutex_lock(&wheel.mtx);
+    while(1){
+        uint64_t now = (uint64_t)((now_ns() - wheel.base_ns) / WHEEL_TICK_NS);
+        if(wheel.armed == 0 && wheel.tick <= now) wheel.tick = now + 1; // nada en ranuras: no hay tics que recorrer
+        while(wheel.tick <= now) wheel_advance_locked(&due);
+        wheel_splice(&due, &wheel.ready);
+
+        while(due.next != &due){
+            wheel_timer_t *t = due.next;
+            wheel_unlink(t);
+            long late = -1;
+            if(t->state == WT_QUEUED){
+                wheel.armed--;
+                late = now_ns() - t->due_ns;
+            }
+            t->state = WT_RUNNING;
+            t->kicked = 0;
+            pthread_mutex_unlock(&wheel.mtx);
+            int ms = t->fn(t->arg, late);
+            pthread_mutex_lock(&wheel.mtx);
+            if(ms < 0){
+                t->state = WT_DONE;
+                pthread_cond_broadcast(&wheel.done_cv);
+            }else if(t->kicked){
+                t->state = WT_READY;
+                wheel_append(&wheel.ready, t);
+            }else{
+                wheel_arm_locked(t, ms);
+            }
+        }
+        if(wheel.ready.next != &wheel.ready) continue;
+
+        // Duerme hasta el próximo tic con trabajo; sin temporizadores, hasta
+        // que alguien arme uno.
+        if(wheel.armed == 0){
+            wheel.sleep_until = UINT64_MAX;
+            pthread_cond_wait(&wheel.cv, &wheel.mtx);
+        }else{
+            wheel.sleep_until = wheel_next_tick_locked();
+            long deadline = wheel.base_ns + (long)wheel.sleep_until * WHEEL_TICK_NS;
+            if(deadline > now_ns()){
+                struct timespec ts = { .tv_sec = deadline / 1000000000L, .tv_nsec = deadline % 1000000000L };
+                pthread_cond_timedwait(&wheel.cv, &wheel.mtx, &ts);
+            }
+        }
+        wheel.sleep_until = 0;
+        atomic_fetch_add_explicit(&sched_wakeups, 1, memory_order_relaxed);
     }
     return NULL;
 }
 
+static void wheel_init(void){
+    pthread_mutex_init(&wheel.mtx, NULL);
+    pthread_condattr_t attr;
+    pthread_condattr_init(&attr);
+    pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+    pthread_cond_init(&wheel.cv, &attr);
+    pthread_condattr_destroy(&attr);
+    pthread_cond_init(&wheel.done_cv, NULL);
+    for(int l=0;l<WHEEL_LEVELS;l++){
+        for(int i=0;i<WHEEL_SLOTS;i++) wheel_list_init(&wheel.slot[l][i]);
+    }
+    wheel_list_init(&wheel.ready);
+    wheel.base_ns = now_ns();
+    pthread_t th;
+    pthread_create(&th, NULL, wheel_thread, NULL);
+    pthread_detach(th);
+}
+
+// Arma t para dentro de ms; el hilo de la rueda se lanza con el primero.
+static void wheel_arm(wheel_timer_t *t, int (*fn)(void *arg, long late_ns), void *arg, int ms){
+    pthread_once(&wheel_once, wheel_init);
+    pthread_mutex_lock(&wheel.mtx);
+    t->fn = fn;
+    t->arg = arg;
+    t->kicked = 0;
+    wheel_arm_locked(t, ms);
+    pthread_mutex_unlock(&wheel.mtx);
+}
+
+// Adelanta t al próximo ciclo del hilo (p. ej. el jugador cedió antes de que
+// venza su cuantum). Si fn está corriendo, se vuelve a llamar al terminar.
+static void wheel_kick(wheel_timer_t *t){
+    pthread_mutex_lock(&wheel.mtx);
+    if(t->state == WT_RUNNING){
+        t->kicked = 1;
+    }else if(t->state == WT_QUEUED){
+        wheel_unlink(t);
+        wheel.armed--;
+        t->state = WT_READY;
+        wheel_append(&wheel.ready, t);
+        if(wheel.sleep_until) pthread_cond_signal(&wheel.cv);
+    }
+    pthread_mutex_unlock(&wheel.mtx);
+}
+
+// Espera a que fn de t devuelva <0; después t puede liberarse.
+static void wheel_wait_done(wheel_timer_t *t){
+    pthread_mutex_lock(&wheel.mtx);
+    while(t->state != WT_DONE) pthread_cond_wait(&wheel.done_cv, &wheel.mtx);
+    pthread_mutex_unlock(&wheel.mtx);
+}
+
 /* ===== Scheduler (HPCS) ===== */
-typedef struct { pcb_t *pcbs; int n; policy_t pol; int quantum_ms; game_state_t *game; } sched_ctx_t;
+typedef struct {
+    pcb_t *pcbs; int n; policy_t pol; int quantum_ms; game_state_t *game;
+    // Estado entre pasos de sched_step.
+    int burst_turn; uint32_t burst_version; // turno y versión de la ráfaga abierta
+    int slice_turn;                         // asiento con la porción en curso (-1 = ninguno)
+    long slice_start_ns, deadline_ns;
+    wheel_timer_t timer;                    // con --sched wheel
+} sched_ctx_t;
 
 static void wake_all_players(pcb_t *pcbs, int n){
     for(int i=0;i<n;i++){
@@ -290,65 +1101,388 @@ static void wake_all_players(pcb_t *pcbs, int n){
     }
 }
 
-static void *scheduler_thread(void *arg){
-    sched_ctx_t *sc = (sched_ctx_t*)arg;
-    int last_turn = 0;
-    while(1){
-        int active = 0;
-        for(int i=0;i<sc->n;i++){
-            if(sc->pcbs[i].st != TERMINATED){
-                active = 1;
-                break;
-            }
-        }
-        if(!active) break;
+static void pcb_set_quantum(pcb_t *p, int q){
+    if(q < cfg.quantum_min_ms) q = cfg.quantum_min_ms;
+    if(q > cfg.quantum_max_ms) q = cfg.quantum_max_ms;
+    if(q == p->quantum_ms) return;
+    p->quantum_ms = q;
+    p->q_hist[p->q_changes % Q_HIST_LEN] = q;
+    p->q_changes++;
+}
 
-        game_state_t *g = sc->game;
-        pthread_mutex_lock(&g->mtx);
-        int finished = g->finished;
-        int turn = g->turn;
-        pthread_mutex_unlock(&g->mtx);
+static void pcb_init_quantum(pcb_t *p, int q){
+    p->quantum_ms = 0;
+    p->burst_ewma_ms = -1.0;
+    p->burst_open = 0;
+    p->q_changes = 0;
+    p->push_ns = 0;
+    p->push_version = UINT32_MAX;
+    pcb_set_quantum(p, q);
+}
 
-        if(finished){
-            wake_all_players(sc->pcbs, sc->n);
-            msleep(10);
-            continue;
-        }
+// Cierra la porción de CPU del jugador: si ya encoló (pushed != 0), su ráfaga
+// (del primer despacho del turno hasta el push) alimenta la EWMA y fija el
+// próximo cuantum; si no, el cuantum se quedó corto y se duplica.
+static void pcb_end_slice(pcb_t *p, long pushed){
+    if(!p->burst_open) return;
+    if(pushed){
+        double burst_ms = (pushed - p->burst_start_ns) / 1e6;
+        p->burst_ewma_ms = (p->burst_ewma_ms < 0) ? burst_ms
+                         : Q_EWMA_ALPHA*burst_ms + (1.0 - Q_EWMA_ALPHA)*p->burst_ewma_ms;
+        p->burst_open = 0;
+        double target = p->burst_ewma_ms * Q_HEADROOM;
+        int q = (int)target;
+        pcb_set_quantum(p, (q < target) ? q + 1 : q);
+    }else{
+        pcb_set_quantum(p, p->quantum_ms * 2);
+    }
+}
 
-        if(turn < 0 || turn >= sc->n){
-            msleep(sc->quantum_ms);
-            continue;
-        }
+// El jugador (o el servidor, por un asiento remoto) cede la CPU al encolar.
+// version es la de la vista con la que decidió: un aviso que llega tarde,
+// cuando la mesa ya volvió a su turno, no cierra la ráfaga nueva.
+static void pcb_yield(pcb_t *p, uint32_t version){
+    pthread_mutex_lock(&p->mtx);
+    p->push_ns = now_ns();
+    p->push_version = version;
+    pthread_cond_signal(&p->yield_cv);
+    pthread_mutex_unlock(&p->mtx);
+    if(p->wheel) wheel_kick(p->wheel);
+}
 
-        pcb_t *p = &sc->pcbs[turn];
-        if(p->st == TERMINATED){
-            pthread_mutex_lock(&g->mtx);
-            int next = next_active_player(g, turn);
-            g->turn = next;
-            pthread_mutex_unlock(&g->mtx);
-            msleep(5);
-            continue;
-        }
+// st lo escribe el hilo del jugador al terminar: se lee con p->mtx.
+static int pcb_terminated(pcb_t *p){
+    pthread_mutex_lock(&p->mtx);
+    int done = (p->st == TERMINATED);
+    pthread_mutex_unlock(&p->mtx);
+    return done;
+}
 
+// Un paso del planificador, sin bloquear: cierra la porción en curso si el
+// jugador ya encoló o venció su cuantum, y si no hay porción abierta revisa la
+// mesa y despacha. Devuelve en cuántos ms quiere el próximo paso (el cuantum
+// mientras hay porción abierta), o -1 cuando todos los PCBs terminaron.
+static int sched_step(sched_ctx_t *sc){
+    game_state_t *g = sc->game;
+    if(sc->slice_turn >= 0){
+        pcb_t *p = &sc->pcbs[sc->slice_turn];
+        long pushed = 0;
         pthread_mutex_lock(&p->mtx);
-        p->st = RUNNING;
-        p->can_run = 1;
-        pthread_cond_signal(&p->run_cv);
+        if(p->push_version == sc->burst_version && p->push_ns >= p->burst_start_ns){
+            pushed = p->push_ns;
+        }
+        long left = sc->deadline_ns - now_ns();
+        int terminated = (p->st == TERMINATED);
+        if(!pushed && !terminated && left > 0){
+            pthread_mutex_unlock(&p->mtx);
+            return (int)((left + 999999) / 1000000);
+        }
         pthread_mutex_unlock(&p->mtx);
-
-        msleep(sc->quantum_ms);
+        if(!pushed && !terminated){
+            // Venció sin jugada: con el cuantum fijo la espera habría durado
+            // --quantum. Una porción cerrada por el push termina igual con
+            // ambos, así que no cuenta.
+            long granted_us = (sc->deadline_ns - sc->slice_start_ns) / 1000;
+            METRIC_ADD(g->metrics, scheduler, idle_saved_us, (long)sc->quantum_ms * 1000 - granted_us);
+        }
 
         pthread_mutex_lock(&p->mtx);
+        pcb_end_slice(p, pushed);
         if(p->st != TERMINATED){
             p->can_run = 0;
             if(p->st == RUNNING) p->st = READY;
         }
         pthread_mutex_unlock(&p->mtx);
-
-        last_turn = turn;
+        sc->slice_turn = -1;
     }
-    wake_all_players(sc->pcbs, sc->n);
-    return NULL;
+
+    int active = 0;
+    for(int i=0;i<sc->n;i++){
+        if(!pcb_terminated(&sc->pcbs[i])){
+            active = 1;
+            break;
+        }
+    }
+    if(!active){
+        wake_all_players(sc->pcbs, sc->n);
+        return -1;
+    }
+
+    table_view_t v = load_view(g);
+    int finished = v.finished;
+    int turn = v.turn;
+
+    if(finished){
+        wake_all_players(sc->pcbs, sc->n);
+        return 10;
+    }
+
+    if(turn < 0 || turn >= sc->n){
+        return sc->quantum_ms;
+    }
+
+    pcb_t *p = &sc->pcbs[turn];
+    if(pcb_terminated(p)){
+        pthread_mutex_lock(&g->mtx);
+        if(!g->finished && g->turn == turn){
+            g->turn = next_active_player(g, turn);
+            publish_view(g);
+        }
+        pthread_mutex_unlock(&g->mtx);
+        return 5;
+    }
+
+    // Un turno nuevo (otro jugador o la misma mesa tras aplicar una
+    // jugada) abre la ráfaga; los redespachos del mismo turno la continúan.
+    int new_burst = (turn != sc->burst_turn || v.version != sc->burst_version);
+    if(!new_burst && !p->burst_open){
+        // Ya encoló: se espera a que el validador la aplique, salvo que la
+        // jugada se haya perdido (p. ej. descartada), y entonces se redespacha.
+        if(now_ns() - p->burst_start_ns < YIELD_STALL_NS){
+            return 1;
+        }
+        p->burst_start_ns = now_ns();
+        p->burst_open = 1;
+    }
+    if(new_burst){
+        sc->burst_turn = turn;
+        sc->burst_version = v.version;
+        p->burst_start_ns = now_ns();
+        p->burst_open = 1;
+        long applied = atomic_load_explicit(&g->applied_ns, memory_order_relaxed);
+        if(applied){
+            LAT_RECORD(g->metrics, LAT_DISPATCH, p->burst_start_ns - applied);
+            LAT_RECORD(g->metrics, LAT_TOTAL,
+                       p->burst_start_ns - atomic_load_explicit(&g->applied_push_ns, memory_order_relaxed));
+        }
+    }
+
+    METRIC_INC(g->metrics, scheduler, dispatches);
+    pthread_mutex_lock(&p->mtx);
+    if(p->st != TERMINATED) p->st = RUNNING; // pudo terminar después de pcb_terminated
+    p->can_run = 1;
+    pthread_cond_signal(&p->run_cv);
+    pthread_mutex_unlock(&p->mtx);
+
+    // La porción dura el cuantum o hasta que el jugador encole su jugada.
+    sc->slice_turn = turn;
+    sc->slice_start_ns = now_ns();
+    sc->deadline_ns = sc->slice_start_ns + (long)p->quantum_ms * 1000000L;
+    return p->quantum_ms;
+}
+
+// Planificador con hilo propio: duerme entre pasos y, durante una porción,
+// espera el aviso de push del jugador hasta que vence el cuantum.
+static void *scheduler_thread(void *arg){
+    sched_ctx_t *sc = (sched_ctx_t*)arg;
+    int ms;
+    while((ms = sched_step(sc)) >= 0){
+        if(sc->slice_turn < 0){
+            long due = now_ns() + (long)ms * 1000000L;
+            msleep(ms);
+            atomic_fetch_add_explicit(&sched_wakeups, 1, memory_order_relaxed);
+            sched_timer_record(now_ns() - due);
+            continue;
+        }
+        pcb_t *p = &sc->pcbs[sc->slice_turn];
+        pthread_mutex_lock(&p->mtx);
+        while(p->st != TERMINATED
+              && !(p->push_version == sc->burst_version && p->push_ns >= p->burst_start_ns)){
+            long left = sc->deadline_ns - now_ns();
+            if(left <= 0){
+                sched_timer_record(-left);
+                break;
+            }
+            cond_wait_ms(&p->yield_cv, &p->mtx, (left + 999999) / 1000000);
+            atomic_fetch_add_explicit(&sched_wakeups, 1, memory_order_relaxed);
+        }
+        pthread_mutex_unlock(&p->mtx);
+    }
+    return NULL;
+}
+
+// Planificador sobre la rueda compartida: cada vencimiento (o wheel_kick desde
+// pcb_yield) es un paso.
+static int sched_wheel_fire(void *arg, long late_ns){
+    if(late_ns >= 0) sched_timer_record(late_ns);
+    return sched_step((sched_ctx_t*)arg);
+}
+
+/* ===== Estrategias de bot ===== */
+static int tile_fits(const bot_view_t *v, tile_t t, int side){
+    int end = (side < 0) ? v->left : v->right;
+    return end == -1 || t.a == end || t.b == end;
+}
+
+// La de siempre: la primera ficha que encaja, por izquierda si puede.
+static int strategy_first(const bot_view_t *v, int *side){
+    for(int i=0;i<v->hand_len;i++){
+        if(tile_fits(v, v->hand[i], -1)){ *side = -1; return i; }
+        if(tile_fits(v, v->hand[i], 1)){ *side = 1; return i; }
+    }
+    return -1;
+}
+
+// Se saca de encima los pips más altos: si pierde por bloqueo, cuentan menos.
+static int strategy_heaviest(const bot_view_t *v, int *side){
+    int best = -1, best_pips = -1;
+    for(int i=0;i<v->hand_len;i++){
+        tile_t t = v->hand[i];
+        int fits_left = tile_fits(v, t, -1);
+        if(!fits_left && !tile_fits(v, t, 1)) continue;
+        if(t.a + t.b > best_pips){
+            best = i;
+            best_pips = t.a + t.b;
+            *side = fits_left ? -1 : 1;
+        }
+    }
+    return best;
+}
+
+// Conserva la mayor cantidad de palos distintos en la mano (más opciones en
+// los turnos siguientes); a igualdad, juega la más pesada.
+static int strategy_suit_diversity(const bot_view_t *v, int *side){
+    int cnt[MAX_PIP+1] = {0};
+    for(int i=0;i<v->hand_len;i++){
+        cnt[v->hand[i].a]++;
+        if(v->hand[i].b != v->hand[i].a) cnt[v->hand[i].b]++;
+    }
+    int best = -1, best_lost = 3, best_pips = -1;
+    for(int i=0;i<v->hand_len;i++){
+        tile_t t = v->hand[i];
+        int fits_left = tile_fits(v, t, -1);
+        if(!fits_left && !tile_fits(v, t, 1)) continue;
+        int lost = (cnt[t.a] == 1) + (t.b != t.a && cnt[t.b] == 1);
+        if(lost < best_lost || (lost == best_lost && t.a + t.b > best_pips)){
+            best = i;
+            best_lost = lost;
+            best_pips = t.a + t.b;
+            *side = fits_left ? -1 : 1;
+        }
+    }
+    return best;
+}
+
+// Una jugada legal cualquiera (ficha y lado), uniforme.
+static int strategy_random(const bot_view_t *v, int *side){
+    int idx[2*MAX_TILES], sides[2*MAX_TILES], n = 0;
+    for(int i=0;i<v->hand_len;i++){
+        if(tile_fits(v, v->hand[i], -1)){ idx[n] = i; sides[n++] = -1; }
+        if(tile_fits(v, v->hand[i], 1)){ idx[n] = i; sides[n++] = 1; }
+    }
+    if(n == 0) return -1;
+    int k = (int)(rng_next(v->rng) % (uint64_t)n);
+    *side = sides[k];
+    return idx[k];
+}
+
+// Recuerda en qué palos pasó cada rival: repasa el historial reconstruyendo
+// los extremos (desconocidos hasta que una colocación los fija) y, cuando
+// alguien pasó, anota los extremos de ese momento como palos que no tiene.
+// Juega la ficha que deja más extremos de esos palos al siguiente asiento;
+// a igualdad, la más pesada.
+static int strategy_memory(const bot_view_t *v, int *side){
+    unsigned lacks[MAX_PLAYERS] = {0};
+    uint32_t live = v->history_count < HISTORY_CAP ? v->history_count : HISTORY_CAP;
+    int left = -1, right = -1;
+    for(uint32_t k=v->history_count-live;k<v->history_count;k++){
+        const hist_move_t *h = &v->history[k % HISTORY_CAP];
+        if(h->side < 0) left = h->t.a;
+        else if(h->side > 0) right = h->t.b;
+        else if(h->player_id < MAX_PLAYERS){
+            if(left >= 0) lacks[h->player_id] |= 1u << left;
+            if(right >= 0) lacks[h->player_id] |= 1u << right;
+        }
+    }
+    unsigned next_lacks = lacks[(v->seat + 1) % v->player_count];
+
+    int best = -1, best_blocked = -1, best_pips = -1;
+    for(int i=0;i<v->hand_len;i++){
+        tile_t t = v->hand[i];
+        for(int s=-1;s<=1;s+=2){
+            if(!tile_fits(v, t, s)) continue;
+            // Extremos tras jugarla, orientada como lo hace apply_move.
+            int end = (s < 0) ? v->left : v->right;
+            int other = (s < 0) ? v->right : v->left;
+            int fresh = (s < 0) ? ((end == -1 || t.b == end) ? t.a : t.b)
+                                : ((end == -1 || t.a == end) ? t.b : t.a);
+            if(other == -1) other = (s < 0) ? t.b : t.a; // tren vacío: la ficha da los dos
+            int blocked = !!(next_lacks & (1u << fresh)) + !!(next_lacks & (1u << other));
+            if(blocked > best_blocked || (blocked == best_blocked && t.a + t.b > best_pips)){
+                best = i;
+                best_blocked = blocked;
+                best_pips = t.a + t.b;
+                *side = s;
+            }
+        }
+    }
+    return best;
+}
+
+static const bot_strategy_t BOT_STRATEGIES[] = {
+    { "primera",    strategy_first,          0 },
+    { "pesada",     strategy_heaviest,       0 },
+    { "diversidad", strategy_suit_diversity, 0 },
+    { "azar",       strategy_random,         0 },
+    { "memoria",    strategy_memory,         1 },
+};
+#define BOT_STRATEGY_COUNT ((int)(sizeof(BOT_STRATEGIES)/sizeof(BOT_STRATEGIES[0])))
+
+static const bot_strategy_t *find_bot_strategy(const char *name, size_t len){
+    for(int i=0;i<BOT_STRATEGY_COUNT;i++){
+        if(strlen(BOT_STRATEGIES[i].name) == len && strncmp(BOT_STRATEGIES[i].name, name, len) == 0){
+            return &BOT_STRATEGIES[i];
+        }
+    }
+    return NULL;
+}
+
+// Arma la vista del asiento pid (copia de la mano bajo su hand_mtx y, si la
+// estrategia lo pide, del historial bajo g->mtx, por separado) y le pide la
+// jugada. Devuelve 1 con ficha y lado, o 0 si no es su turno o no puede jugar.
+static int bot_choose(game_state_t *g, int pid, const bot_strategy_t *s, uint64_t *rng, tile_t *out, int *side){
+    table_view_t tv = load_view(g);
+    if(tv.turn != pid) return 0;
+    tile_t hand[MAX_TILES];
+    hist_move_t history[HISTORY_CAP];
+    bot_view_t v = { .hand = hand, .left = tv.left, .right = tv.right, .pool = pool_count(g),
+                     .seat = pid, .player_count = g->player_count, .rng = rng };
+    pthread_mutex_lock(&g->hand_mtx[pid]);
+    v.hand_len = g->hand_len[pid];
+    memcpy(hand, g->hands[pid], sizeof(tile_t)*v.hand_len);
+    pthread_mutex_unlock(&g->hand_mtx[pid]);
+    if(s->uses_history){
+        pthread_mutex_lock(&g->mtx);
+        memcpy(history, g->history, sizeof(history));
+        v.history_count = g->history_count;
+        pthread_mutex_unlock(&g->mtx);
+        v.history = history;
+    }
+    int idx = s->choose(&v, side);
+    if(idx < 0 || idx >= v.hand_len) return 0;
+    *out = hand[idx];
+    return 1;
+}
+
+/* ===== Corrutinas (--exec coro) ===== */
+// Con --exec coro los asientos de una mesa son corrutinas sobre un único hilo,
+// table_thread, que hace de planificador y de validador: pasar el turno es un
+// swapcontext en lugar de despertar otro hilo. El planificador es cooperativo:
+// el asiento corre hasta que cede, sin cuantum que lo interrumpa.
+#define CORO_STACK (128*1024)
+
+typedef struct {
+    ucontext_t runner;               // contexto de table_thread
+    ucontext_t seat[MAX_PLAYERS];
+    char *stacks;                    // CORO_STACK bytes por asiento
+    int done[MAX_PLAYERS];           // la corrutina del asiento ya retornó
+    int wait_ms;                     // espera que pidió el asiento al ceder
+    int queue_full;                  // cedió esperando lugar en la cola de movimientos
+} coro_table_t;
+
+static void coro_yield(coro_table_t *co, int seat, int wait_ms){
+    co->wait_ms = wait_ms;
+    swapcontext(&co->seat[seat], &co->runner);
 }
 
 /* ===== Player thread ===== */
@@ -357,8 +1491,37 @@ typedef struct {
     game_state_t *g;
     pcb_t *pcb;
     bool is_human;
+    bool is_remote;       // asiento de un cliente del servidor de sockets
+    human_inbox_t *inbox;
+    const bot_strategy_t *strategy;
+    uint64_t rng;
+    coro_table_t *coro;   // NULL: el asiento tiene su propio hilo
 } player_ctx_t;
 
+// Espera del asiento: en su hilo duerme; como corrutina cede a table_thread,
+// que mientras tanto atiende la cola de la mesa.
+static void seat_wait(player_ctx_t *cx, int ms){
+    if(cx->coro) coro_yield(cx->coro, cx->id, ms);
+    else msleep(ms);
+}
+
+// Encola la jugada del asiento según --queue-full. Una corrutina no puede
+// esperar en q_space_cv sin detener a toda su mesa: con block reintenta
+// cediendo a table_thread, que entretanto vacía la cola de la mesa.
+static int seat_push(player_ctx_t *cx, const move_t *m){
+    if(!cx->coro) return moveq_push(m);
+    if(cfg.queue_full == QFULL_FAIL) return moveq_try_push(m);
+    long t0 = 0;
+    while(!moveq_push_mode(m, QPUSH_POLL)){
+        if(t0 == 0) t0 = now_ns();
+        cx->coro->queue_full = 1;
+        seat_wait(cx, 1);
+        cx->coro->queue_full = 0;
+    }
+    if(t0) moveq_note_wait(now_ns() - t0);
+    return 1;
+}
+
 struct table_runtime_t {
     game_state_t state;
     pcb_t *pcbs;
@@ -368,14 +1531,26 @@ struct table_runtime_t {
     pthread_t scheduler_thread;
     sched_ctx_t scheduler_ctx;
     int seats;
+    int human_seat;       // -1 si la mesa solo tiene bots
+    human_inbox_t *inbox; // comandos enrutados por input_thread (solo con humano)
+    coro_table_t *coro;   // solo con --exec coro: asientos como corrutinas...
+    pthread_t runner_thread; // ...sobre este único hilo (table_thread)
 };
 
 typedef struct {
     table_runtime_t *tables;
     int table_count;
     int interval_ms;
+    int quiet;            // solo exporta métricas, sin imprimir mesas
 } reporter_ctx_t;
 
+// SIGUSR1 (o "lat" en consola) pide al reporter los percentiles de latencia.
+static atomic_int latency_dump_requested;
+static void on_latency_signal(int sig){ (void)sig; atomic_store(&latency_dump_requested, 1); }
+// SIGUSR2 (o "ckpt" en consola) pide al reporter un checkpoint de todas las mesas.
+static atomic_int checkpoint_requested;
+static void on_checkpoint_signal(int sig){ (void)sig; atomic_store(&checkpoint_requested, 1); }
+
 static void tile_to_string(tile_t t, char *buf, size_t n){
     if(t.a < 0 || t.b < 0){
         snprintf(buf, n, "PASS");
@@ -384,6 +1559,8 @@ static void tile_to_string(tile_t t, char *buf, size_t n){
     }
 }
 
+#define TRAIN_STR_LEN (MAX_TILES*9 + 16) // "[12|12]-" por ficha en doble-doce
+
 static void describe_train(const tile_t *train, int len, char *buf, size_t n){
     buf[0] = '\0';
     size_t used = 0;
@@ -400,31 +1577,59 @@ static void describe_train(const tile_t *train, int len, char *buf, size_t n){
     }
 }
 
-static int human_take_turn(player_ctx_t *cx){
+// Jugada automática cuando vence el plazo del turno o stdin se cierra. Las dos
+// acciones respetan la regla del pase: se roba hasta tener jugada o vaciar el
+// pozo, y solo se pasa si aun así nada encaja. Con play elige la estrategia
+// del asiento, como un bot; con pass se juega lo mínimo: la primera que encaje.
+static int human_auto_move(player_ctx_t *cx){
+    game_state_t *g = cx->g;
+    int pid = cx->id;
+    table_view_t v = load_view(g);
+    if(v.finished || v.turn != pid) return 0;
+    move_t mv = { .player_id = pid, .table_id = g->table_id, .t = { .a=-1, .b=-1 }, .side = 0 };
+    tile_t t; int side = 0;
+    while(!can_play(g, pid, &t, &side) && draw_from_pool(g, pid)){}
+    if(cfg.timeout_action == TIMEOUT_PLAY ? bot_choose(g, pid, cx->strategy, &cx->rng, &t, &side)
+                                          : can_play(g, pid, &t, &side)){
+        mv.t = t;
+        mv.side = side;
+    }
+    // Nadie verá un rechazo: se reintenta mientras siga siendo su turno.
+    while(!seat_push(cx, &mv)){
+        v = load_view(g);
+        if(v.finished || v.turn != pid) return 0;
+        seat_wait(cx, 5);
+    }
+    char tile_buf[16];
+    tile_to_string(mv.t, tile_buf, sizeof(tile_buf));
+    io_printf("[%s] Mesa %d: sin respuesta, se envió %s automáticamente.\n", cx->is_remote?"Remoto":"Humano", g->table_id+1, tile_buf);
+    return 1;
+}
+
+static int human_turn_loop(player_ctx_t *cx){
     game_state_t *g = cx->g;
     int pid = cx->id;
+    long deadline = (cfg.turn_timeout_ms > 0) ? now_ms() + cfg.turn_timeout_ms : -1;
     while(1){
-        pthread_mutex_lock(&io_mtx);
+        table_view_t v = load_view(g);
+        if(v.finished || v.turn != pid) return 0;
+        tile_t train_copy[MAX_TILES];
         pthread_mutex_lock(&g->mtx);
-        if(g->finished || g->turn != pid){
-            pthread_mutex_unlock(&g->mtx);
-            pthread_mutex_unlock(&io_mtx);
-            return 0;
-        }
-        tile_t train_copy[64];
         int train_len = g->train_len;
-        if(train_len > 64) train_len = 64;
         memcpy(train_copy, g->train, sizeof(tile_t)*train_len);
-        tile_t hand_copy[14];
+        pthread_mutex_unlock(&g->mtx);
+        tile_t hand_copy[MAX_TILES];
+        pthread_mutex_lock(&g->hand_mtx[pid]);
         int hand_len = g->hand_len[pid];
-        if(hand_len > 14) hand_len = 14;
         memcpy(hand_copy, g->hands[pid], sizeof(tile_t)*hand_len);
-        int left = g->left_end;
-        int right = g->right_end;
-        int pool_len = g->pool_len;
-        pthread_mutex_unlock(&g->mtx);
-        char train_buf[512];
+        pthread_mutex_unlock(&g->hand_mtx[pid]);
+        int left = v.left;
+        int right = v.right;
+        int pool_len = pool_count(g);
+        char train_buf[TRAIN_STR_LEN];
         describe_train(train_copy, train_len, train_buf, sizeof(train_buf));
+
+        pthread_mutex_lock(&io_mtx);
         printf("\n[Humano] Mesa %d - Turno Jugador %d\n", g->table_id+1, pid+1);
         printf("Tren: %s (izq=%d, der=%d)\n", train_buf, left, right);
         printf("Fichas en mano:\n");
@@ -434,125 +1639,116 @@ static int human_take_turn(player_ctx_t *cx){
             printf("  %2d: %s\n", i+1, tile_buf);
         }
         printf("Fichas en pozo: %d\n", pool_len);
-        printf("Opciones: [j] jugar, [c] comprar, [p] pasar\n> ");
+        printf("Opciones: j <n> <i|d> jugar, c comprar, p pasar (anteponga m%d si varias mesas esperan)\n> ", g->table_id+1);
         fflush(stdout);
-        char line[64];
-        if(!fgets(line, sizeof(line), stdin)){
-            clearerr(stdin);
-            pthread_mutex_unlock(&io_mtx);
-            return 0;
+        pthread_mutex_unlock(&io_mtx);
+
+        char line[LINE_LEN];
+        if(!inbox_wait_line(cx->inbox, deadline, line, sizeof(line))){
+            return human_auto_move(cx);
         }
-        char opt = tolower((unsigned char)line[0]);
-        int action_done = 0;
+        char opt = 0, side_c = 0;
+        int tile_index = 0;
+        int fields = sscanf(line, " %c %d %c", &opt, &tile_index, &side_c);
+        opt = tolower((unsigned char)opt);
         switch(opt){
             case 'j': {
-                if(hand_len == 0){
-                    printf("No tiene fichas para jugar.\n");
-                    break;
-                }
-                int tile_index = -1;
-                while(1){
-                    printf("Seleccione el índice de la ficha (1-%d): ", hand_len);
-                    fflush(stdout);
-                    if(!fgets(line, sizeof(line), stdin)){
-                        clearerr(stdin);
-                        break;
-                    }
-                    if(sscanf(line, "%d", &tile_index) == 1){
-                        tile_index -= 1;
-                        if(tile_index >=0 && tile_index < hand_len) break;
-                    }
-                    printf("Índice inválido.\n");
-                }
-                if(tile_index < 0 || tile_index >= hand_len) break;
                 int selected_side = 0;
-                while(selected_side == 0){
-                    printf("Seleccione el lado (i=izquierda, d=derecha): ");
-                    fflush(stdout);
-                    if(!fgets(line, sizeof(line), stdin)){
-                        clearerr(stdin);
-                        break;
-                    }
-                    char c = tolower((unsigned char)line[0]);
-                    if(c == 'i') selected_side = -1;
-                    else if(c == 'd') selected_side = 1;
-                    else printf("Opción inválida.\n");
-                }
-                if(selected_side == 0) break;
-
-                pthread_mutex_lock(&g->mtx);
-                if(g->finished || g->turn != pid){
-                    pthread_mutex_unlock(&g->mtx);
-                    pthread_mutex_unlock(&io_mtx);
-                    return 0;
+                side_c = tolower((unsigned char)side_c);
+                if(side_c == 'i') selected_side = -1;
+                else if(side_c == 'd') selected_side = 1;
+                if(fields < 3 || selected_side == 0){
+                    io_printf("Uso: j <índice 1-%d> <i|d>\n", hand_len);
+                    break;
                 }
-                if(tile_index >= g->hand_len[pid]){
-                    pthread_mutex_unlock(&g->mtx);
-                    printf("La ficha seleccionada ya no está disponible.\n");
+                tile_index -= 1;
+                v = load_view(g);
+                if(v.finished || v.turn != pid) return 0;
+                pthread_mutex_lock(&g->hand_mtx[pid]);
+                int valid_index = (tile_index >= 0 && tile_index < g->hand_len[pid]);
+                tile_t tile = valid_index ? g->hands[pid][tile_index] : (tile_t){ .a=-1, .b=-1 };
+                pthread_mutex_unlock(&g->hand_mtx[pid]);
+                if(!valid_index){
+                    io_printf("Índice inválido.\n");
                     break;
                 }
-                tile_t tile = g->hands[pid][tile_index];
-                int target = (selected_side < 0) ? g->left_end : g->right_end;
+                int target = (selected_side < 0) ? v.left : v.right;
                 if(target != -1 && !(tile.a == target || tile.b == target)){
-                    pthread_mutex_unlock(&g->mtx);
-                    printf("La ficha no encaja en ese lado.\n");
+                    io_printf("La ficha no encaja en ese lado.\n");
                     break;
                 }
                 move_t mv = { .player_id = pid, .table_id = g->table_id, .t = tile, .side = selected_side };
-                moveq_push(&mv);
-                pthread_mutex_unlock(&g->mtx);
+                if(!seat_push(cx, &mv)){
+                    io_printf("Cola de jugadas llena; intente de nuevo.\n");
+                    break;
+                }
                 char tile_buf[16];
                 tile_to_string(tile, tile_buf, sizeof(tile_buf));
-                printf("Jugada enviada: %s al lado %s.\n", tile_buf, (selected_side<0)?"izquierdo":"derecho");
-                action_done = 1;
-                break;
+                io_printf("Jugada enviada: %s al lado %s.\n", tile_buf, (selected_side<0)?"izquierdo":"derecho");
+                return 1;
             }
             case 'c': {
-                pthread_mutex_lock(&g->mtx);
                 if(draw_from_pool(g, pid)){
+                    pthread_mutex_lock(&g->hand_mtx[pid]);
                     tile_t new_tile = g->hands[pid][g->hand_len[pid]-1];
-                    pthread_mutex_unlock(&g->mtx);
+                    pthread_mutex_unlock(&g->hand_mtx[pid]);
                     char tile_buf[16];
                     tile_to_string(new_tile, tile_buf, sizeof(tile_buf));
-                    printf("Robó la ficha %s.\n", tile_buf);
+                    io_printf("Robó la ficha %s.\n", tile_buf);
                 }else{
-                    int pool_empty = (g->pool_len == 0);
-                    pthread_mutex_unlock(&g->mtx);
+                    int pool_empty = (pool_count(g) == 0);
                     if(pool_empty){
-                        printf("No quedan fichas en el pozo.\n");
+                        io_printf("No quedan fichas en el pozo.\n");
                     }else{
-                        printf("No fue posible robar una ficha.\n");
+                        io_printf("No fue posible robar una ficha.\n");
                     }
                 }
                 break;
             }
             case 'p': {
-                pthread_mutex_lock(&g->mtx);
-                int pool_empty = (g->pool_len == 0);
+                int pool_empty = (pool_count(g) == 0);
                 tile_t dummy; int dummy_side;
                 int can = can_play(g, pid, &dummy, &dummy_side);
                 if(!pool_empty || can){
-                    pthread_mutex_unlock(&g->mtx);
-                    printf("No puede pasar: aún tiene jugadas o el pozo no está vacío.\n");
+                    io_printf("No puede pasar: aún tiene jugadas o el pozo no está vacío.\n");
                     break;
                 }
                 move_t mv = { .player_id = pid, .table_id = g->table_id, .t = { .a=-1, .b=-1 }, .side = 0 };
-                moveq_push(&mv);
-                pthread_mutex_unlock(&g->mtx);
-                printf("Se registró el pase de turno.\n");
-                action_done = 1;
-                break;
+                if(!seat_push(cx, &mv)){
+                    io_printf("Cola de jugadas llena; intente de nuevo.\n");
+                    break;
+                }
+                io_printf("Se registró el pase de turno.\n");
+                return 1;
             }
             default:
-                printf("Opción no reconocida.\n");
+                io_printf("Opción no reconocida.\n");
                 break;
         }
-        pthread_mutex_unlock(&io_mtx);
-        if(action_done) return 1;
     }
     return 0;
 }
 
+static int human_take_turn(player_ctx_t *cx){
+    inbox_set_waiting(cx->inbox, 1);
+    int performed = human_turn_loop(cx);
+    inbox_set_waiting(cx->inbox, 0);
+    return performed;
+}
+
+// El cliente remoto envía su jugada por el servidor de sockets, que la encola
+// directamente; el hilo del asiento solo vigila el plazo del turno.
+static int remote_take_turn(player_ctx_t *cx){
+    game_state_t *g = cx->g;
+    long deadline = (cfg.turn_timeout_ms > 0) ? now_ms() + cfg.turn_timeout_ms : -1;
+    while(1){
+        table_view_t v = load_view(g);
+        if(v.finished || v.turn != cx->id) return 1;
+        if(deadline >= 0 && now_ms() >= deadline) return human_auto_move(cx);
+        seat_wait(cx, 2);
+    }
+}
+
 static void *player_thread(void *arg){
     player_ctx_t *cx = (player_ctx_t*)arg;
     pcb_t *pcb = cx->pcb; game_state_t *g = cx->g;
@@ -561,63 +1757,58 @@ static void *player_thread(void *arg){
         while(!pcb->can_run) pthread_cond_wait(&pcb->run_cv, &pcb->mtx);
         pthread_mutex_unlock(&pcb->mtx);
 
-        pthread_mutex_lock(&g->mtx);
-        if(g->finished){
-            pthread_mutex_unlock(&g->mtx);
-            break;
-        }
-        if(g->turn != cx->id){
-            pthread_mutex_unlock(&g->mtx);
-            msleep(5);
+        table_view_t v = load_view(g);
+        if(v.finished) break;
+        if(v.turn != cx->id){
+            seat_wait(cx, 5);
             continue;
         }
-        pthread_mutex_unlock(&g->mtx);
+        uint32_t seen_version = v.version;
 
         int performed = 0;
         if(cx->is_human){
             performed = human_take_turn(cx);
+        }else if(cx->is_remote){
+            performed = remote_take_turn(cx);
         }else{
             tile_t t; int side=0;
-            pthread_mutex_lock(&g->mtx);
-            int ok = can_play(g, cx->id, &t, &side);
-            pthread_mutex_unlock(&g->mtx);
+            int ok = bot_choose(g, cx->id, cx->strategy, &cx->rng, &t, &side);
 
             if(ok){
                 move_t mv = { .player_id=cx->id, .table_id=g->table_id, .t=t, .side=side };
-                moveq_push(&mv);
-                performed = 1;
+                // Rechazada por cola llena: se reintenta en el próximo cuantum.
+                performed = seat_push(cx, &mv);
+                if(!performed) seat_wait(cx, 5);
             }else{
-                pthread_mutex_lock(&g->mtx);
                 int drew = draw_from_pool(g, cx->id);
-                int pool_empty = (g->pool_len == 0);
-                pthread_mutex_unlock(&g->mtx);
+                int pool_empty = (pool_count(g) == 0);
                 if(!drew && pool_empty){
                     move_t pass = { .player_id=cx->id, .table_id=g->table_id, .t={.a=-1,.b=-1}, .side=0 };
-                    moveq_push(&pass);
-                    performed = 1;
+                    performed = seat_push(cx, &pass);
+                    if(!performed) seat_wait(cx, 5);
                 }else{
-                    msleep(5);
+                    seat_wait(cx, 5);
                 }
             }
         }
 
         if(performed){
+            pcb_yield(pcb, seen_version);
             int wait_loops = 0;
             while(1){
-                pthread_mutex_lock(&g->mtx);
-                int finished = g->finished;
-                int turn_now = g->turn;
-                pthread_mutex_unlock(&g->mtx);
-                if(finished || turn_now != cx->id) break;
-                msleep(2);
+                // Se espera a que el validador aplique la jugada; comparar solo el
+                // turno falla con 2 jugadores si el rival juega antes del sondeo.
+                table_view_t now = load_view(g);
+                if(now.finished || now.version != seen_version) break;
+                seat_wait(cx, 2);
                 if(++wait_loops > 1000) break;
             }
         }
 
-        pthread_mutex_lock(&g->mtx);
-        int finished = g->finished;
+        int finished = load_view(g).finished;
+        pthread_mutex_lock(&g->hand_mtx[cx->id]);
         int hand_empty = (g->hand_len[cx->id] == 0);
-        pthread_mutex_unlock(&g->mtx);
+        pthread_mutex_unlock(&g->hand_mtx[cx->id]);
         if(finished || hand_empty){
             break;
         }
@@ -638,7 +1829,7 @@ static void print_table_state(table_runtime_t *table, int force){
     }
 
     game_state_t *g = &table->state;
-    tile_t train_copy[64]; int train_len = 0;
+    tile_t train_copy[MAX_TILES]; int train_len = 0;
     int left = -1, right = -1;
     int pool_len = 0;
     int turn = -1;
@@ -649,37 +1840,40 @@ static void print_table_state(table_runtime_t *table, int force){
     int human_id = -1;
     int hand_len[MAX_PLAYERS] = {0};
     int points[MAX_PLAYERS] = {0};
-    move_t history_buf[16]; int history_len = 0;
+    hist_move_t history_buf[16]; int history_len = 0;
     int table_id = 0;
 
-    pthread_mutex_lock(&g->mtx);
     table_id = g->table_id;
-    finished = g->finished;
-    winner = g->winner;
-    blocked = g->blocked;
     player_count = g->player_count;
     human_id = g->human_player;
-    turn = g->turn;
-    pool_len = g->pool_len;
-    left = g->left_end;
-    right = g->right_end;
-    train_len = g->train_len;
-    if(train_len > 64) train_len = 64;
-    memcpy(train_copy, g->train, sizeof(tile_t)*train_len);
+    pool_len = pool_count(g);
     for(int i=0;i<player_count && i<MAX_PLAYERS;i++){
+        pthread_mutex_lock(&g->hand_mtx[i]);
         hand_len[i] = g->hand_len[i];
+        pthread_mutex_unlock(&g->hand_mtx[i]);
         points[i] = compute_hand_points(g, i);
     }
-    int start = 0;
-    if(g->history_len > 16) start = g->history_len - 16;
-    history_len = g->history_len - start;
-    if(history_len < 0) history_len = 0;
+
+    // g->mtx sólo para la copia del tren y el historial.
+    pthread_mutex_lock(&g->mtx);
+    table_view_t v = load_view(g);
+    finished = v.finished;
+    turn = v.turn;
+    left = v.left;
+    right = v.right;
+    winner = g->winner;
+    blocked = g->blocked;
+    train_len = g->train_len;
+    memcpy(train_copy, g->train, sizeof(tile_t)*train_len);
+    uint32_t start = 0;
+    if(g->history_count > 16) start = g->history_count - 16;
+    history_len = (int)(g->history_count - start);
     for(int i=0;i<history_len;i++){
-        history_buf[i] = g->history[start + i];
+        history_buf[i] = g->history[(start + i) % HISTORY_CAP];
     }
     pthread_mutex_unlock(&g->mtx);
 
-    char train_str[512];
+    char train_str[TRAIN_STR_LEN];
     describe_train(train_copy, train_len, train_str, sizeof(train_str));
 
     printf("\n=== Mesa %d ===\n", table_id + 1);
@@ -697,7 +1891,7 @@ static void print_table_state(table_runtime_t *table, int force){
     if(history_len > 0){
         printf("Historial reciente:\n");
         for(int i=0;i<history_len;i++){
-            move_t mv = history_buf[i];
+            hist_move_t mv = history_buf[i];
             char tile_buf[16];
             tile_to_string(mv.t, tile_buf, sizeof(tile_buf));
             if(mv.side == 0){
@@ -718,97 +1912,1864 @@ static void print_table_state(table_runtime_t *table, int force){
     pthread_mutex_unlock(&io_mtx);
 }
 
-/* ===== Mesa (opcional si solo hay una) ===== */
-static void *table_thread(void *arg){
-    game_state_t *g = (game_state_t*)arg;
-    // TODO: orquestar turnos si no usa planificador global
-    (void)g;
-    return NULL;
+/* ===== Hilo de entrada ===== */
+typedef struct {
+    table_runtime_t *tables;
+    int table_count;
+    atomic_int stop;
+} input_ctx_t;
+
+// Entrega la línea al humano que espera: el de la mesa indicada con el
+// prefijo "m<N>" o, sin prefijo, el que lleva más tiempo esperando.
+static void route_input_line(input_ctx_t *ix, const char *line){
+    const char *cmd = line;
+    while(isspace((unsigned char)*cmd)) cmd++;
+    if(*cmd == '\0') return;
+    if(strncmp(cmd, "lat", 3) == 0 && (cmd[3] == '\0' || isspace((unsigned char)cmd[3]))){
+        atomic_store(&latency_dump_requested, 1);
+        return;
+    }
+    if(strncmp(cmd, "ckpt", 4) == 0 && (cmd[4] == '\0' || isspace((unsigned char)cmd[4]))){
+        if(cfg.checkpoint_path) atomic_store(&checkpoint_requested, 1);
+        else io_printf("Sin --checkpoint RUTA no hay dónde guardar.\n");
+        return;
+    }
+    int table = -1;
+    if((cmd[0] == 'm' || cmd[0] == 'M') && isdigit((unsigned char)cmd[1])){
+        char *end;
+        table = (int)strtol(cmd+1, &end, 10) - 1;
+        cmd = end;
+    }
+
+    human_inbox_t *target = NULL;
+    long best_seq = 0;
+    for(int t=0;t<ix->table_count;t++){
+        table_runtime_t *tbl = &ix->tables[t];
+        if(tbl->human_seat < 0) continue;
+        if(table >= 0 && t != table) continue;
+        pthread_mutex_lock(&tbl->inbox->mtx);
+        if(tbl->inbox->waiting && (!target || tbl->inbox->wait_seq < best_seq)){
+            target = tbl->inbox;
+            best_seq = tbl->inbox->wait_seq;
+        }
+        pthread_mutex_unlock(&tbl->inbox->mtx);
+    }
+
+    int delivered = 0;
+    if(target){
+        pthread_mutex_lock(&target->mtx);
+        if(target->waiting && target->count < INBOX_LINES){
+            int slot = (target->head + target->count) % INBOX_LINES;
+            snprintf(target->lines[slot], LINE_LEN, "%s", cmd);
+            target->count++;
+            pthread_cond_signal(&target->cv);
+            delivered = 1;
+        }
+        pthread_mutex_unlock(&target->mtx);
+    }
+    if(!delivered){
+        if(table >= 0){
+            io_printf("La mesa %d no espera una jugada humana.\n", table+1);
+        }else{
+            io_printf("Ningún jugador humano espera una jugada.\n");
+        }
+    }
 }
 
-static void *reporter_thread(void *arg){
-    reporter_ctx_t *ctx = (reporter_ctx_t*)arg;
-    while(1){
-        int all_finished = 1;
-        for(int i=0;i<ctx->table_count;i++){
-            game_state_t *g = &ctx->tables[i].state;
-            pthread_mutex_lock(&g->mtx);
-            int finished = g->finished;
-            pthread_mutex_unlock(&g->mtx);
-            if(!finished) all_finished = 0;
-            print_table_state(&ctx->tables[i], 0);
+static void *input_thread(void *arg){
+    input_ctx_t *ix = (input_ctx_t*)arg;
+    char line[LINE_LEN];
+    while(!atomic_load(&ix->stop)){
+        if(input_take_line(line, sizeof(line))){
+            route_input_line(ix, line);
+            continue;
+        }
+        if(input_fill(100) < 0){
+            // stdin cerrado: los humanos pasan a jugada automática.
+            atomic_store(&input_closed, 1);
+            for(int t=0;t<ix->table_count;t++){
+                if(ix->tables[t].human_seat < 0) continue;
+                pthread_mutex_lock(&ix->tables[t].inbox->mtx);
+                pthread_cond_broadcast(&ix->tables[t].inbox->cv);
+                pthread_mutex_unlock(&ix->tables[t].inbox->mtx);
+            }
+            break;
         }
-        if(all_finished) break;
-        msleep(ctx->interval_ms);
     }
     return NULL;
 }
 
-/* ===== Utilidades ===== */
-static void shuffle(tile_t *v, int n){
-    for(int i=n-1;i>0;i--){
-        int j = rand() % (i+1);
-        tile_t tmp = v[i]; v[i]=v[j]; v[j]=tmp;
+/* ===== Ubicación de hilos (afinidad) ===== */
+// Las CPUs permitidas al proceso se reparten en cubetas (un núcleo, un grupo
+// de núcleos consecutivos o un nodo NUMA) y la mesa t usa la cubeta t % n.
+static cpu_set_t *placement_sets; static int placement_count;
+
+// Formato de /sys: "0-3,8,10-11".
+static void parse_cpulist(const char *list, cpu_set_t *set){
+    CPU_ZERO(set);
+    const char *p = list;
+    while(*p){
+        char *end;
+        long lo = strtol(p, &end, 10);
+        if(end == p) break;
+        long hi = lo;
+        if(*end == '-') hi = strtol(end+1, &end, 10);
+        for(long c=lo;c<=hi && c<CPU_SETSIZE;c++) CPU_SET((int)c, set);
+        p = (*end == ',') ? end+1 : end;
+        if(*p == '\n') break;
     }
 }
 
-static void build_shuffled_deck(tile_t *deck, int *out_len){
-    int idx = 0;
-    for(int a = 0; a <= 6; ++a){
-        for(int b = a; b <= 6; ++b){
-            deck[idx++] = (tile_t){ .a = a, .b = b };
+static int placement_add(const cpu_set_t *set){
+    cpu_set_t *grown = realloc(placement_sets, sizeof(cpu_set_t)*(placement_count+1));
+    if(!grown) return 0;
+    placement_sets = grown;
+    placement_sets[placement_count++] = *set;
+    return 1;
+}
+
+static int placement_init(pin_mode_t mode, int group){
+    placement_count = 0;
+    if(mode == PIN_NONE) return 1;
+    cpu_set_t allowed;
+    if(sched_getaffinity(0, sizeof(allowed), &allowed) != 0) return 0;
+
+    if(mode == PIN_NODE){
+        DIR *d = opendir("/sys/devices/system/node");
+        struct dirent *e;
+        while(d && (e = readdir(d))){
+            if(strncmp(e->d_name, "node", 4) != 0 || !isdigit((unsigned char)e->d_name[4])) continue;
+            char path[300], list[512];
+            snprintf(path, sizeof(path), "/sys/devices/system/node/%s/cpulist", e->d_name);
+            FILE *f = fopen(path, "r");
+            if(!f) continue;
+            if(fgets(list, sizeof(list), f)){
+                cpu_set_t node;
+                parse_cpulist(list, &node);
+                CPU_AND(&node, &node, &allowed);
+                if(CPU_COUNT(&node) > 0) placement_add(&node);
+            }
+            fclose(f);
         }
+        if(d) closedir(d);
+        if(placement_count == 0) placement_add(&allowed); // sin NUMA expuesto: un solo nodo
+        return placement_count > 0;
     }
-    *out_len = idx;
-    shuffle(deck, idx);
+
+    int per_bucket = (mode == PIN_CORE) ? 1 : group;
+    cpu_set_t bucket; CPU_ZERO(&bucket);
+    int in_bucket = 0;
+    for(int c=0;c<CPU_SETSIZE;c++){
+        if(!CPU_ISSET(c, &allowed)) continue;
+        CPU_SET(c, &bucket);
+        if(++in_bucket == per_bucket){
+            if(!placement_add(&bucket)) return 0;
+            CPU_ZERO(&bucket);
+            in_bucket = 0;
+        }
+    }
+    if(in_bucket > 0 && !placement_add(&bucket)) return 0;
+    return placement_count > 0;
 }
 
-static void setup_game_state(game_state_t *g, int table_id, int player_count, int human_player){
-    tile_t deck[MAX_TILES];
-    int deck_len = 0;
-    build_shuffled_deck(deck, &deck_len);
+static void placement_apply(pthread_t th, int table_id){
+    if(placement_count == 0) return;
+    pthread_setaffinity_np(th, sizeof(cpu_set_t), &placement_sets[table_id % placement_count]);
+}
 
-    g->table_id = table_id;
-    g->player_count = player_count;
-    g->human_player = human_player;
-    g->finished = 0;
-    g->train_len = 0;
-    g->left_end = -1;
-    g->right_end = -1;
-    g->pool_len = 0;
-    g->turn = 0;
-    g->winner = -1;
-    g->blocked = 0;
-    g->passes_in_row = 0;
-    g->history_len = 0;
+static void placement_free(void){
+    free(placement_sets);
+    placement_sets = NULL;
+    placement_count = 0;
+}
 
-    for(int pid = 0; pid < MAX_PLAYERS; ++pid){
-        g->hand_len[pid] = 0;
+/* ===== Checkpoint ===== */
+// Un archivo binario con todas las mesas: cabecera y un registro de tamaño fijo
+// por mesa (record_size depende del juego), en el orden de bytes de quien lo
+// escribió. Cada registro guarda fichas (manos en orden, pozo y tren), turno,
+// extremos, historial y el estado de los PCBs; las jugadas que estaban en la
+// cola no se guardan y el jugador vuelve a decidir al reanudar. Al reanudar el
+// archivo se mapea con mmap y cada mesa se reconstruye sin volver a repartir.
+#define CKPT_MAGIC "DOMCKPT"
+#define CKPT_VERSION 1
+#define CKPT_BYTE_ORDER 0x01020304u
+
+typedef struct {
+    char magic[8];
+    uint32_t version;
+    uint32_t byte_order;
+    uint32_t header_size, record_size;
+    uint32_t table_count;
+    int32_t max_pip;
+} ckpt_header_t;
+
+typedef struct {
+    uint8_t st;              // pstate_t; RUNNING se reanuda como READY
+    uint8_t pad[3];
+    int32_t quantum_ms;
+    double burst_ewma_ms;
+} ckpt_pcb_t;
+
+typedef struct {
+    int32_t table_id;
+    uint32_t version, history_count;
+    uint8_t seats; int8_t human_seat; int8_t turn; uint8_t finished;
+    int8_t winner; uint8_t blocked; uint8_t passes_in_row; uint8_t train_len;
+    int8_t left_end, right_end; uint8_t pool_len; uint8_t pad;
+    uint8_t hand_len[MAX_PLAYERS];
+    ckpt_pcb_t pcb[MAX_PLAYERS];
+    hist_move_t history[HISTORY_CAP];
+    tile_t tiles[];          // set->tiles fichas: manos, pozo y tren
+} ckpt_table_t;
+
+static size_t ckpt_record_size(const domino_set_t *set){
+    size_t bytes = sizeof(ckpt_table_t) + sizeof(tile_t)*(size_t)set->tiles;
+    return (bytes + 7) & ~(size_t)7; // los registros mapeados quedan alineados a 8
+}
+
+static const ckpt_table_t *ckpt_record(const ckpt_header_t *h, int i){
+    return (const ckpt_table_t*)((const char*)h + h->header_size + (size_t)h->record_size*i);
+}
+
+// Copia coherente de una mesa en marcha: g->mtx y todas las manos (que además
+// congelan el pozo, porque robar exige la mano del que roba). Los PCBs se leen
+// después, cada uno bajo su mtx. rec debe venir en cero.
+static void snapshot_table(table_runtime_t *tbl, ckpt_table_t *rec){
+    game_state_t *g = &tbl->state;
+    pthread_mutex_lock(&g->mtx);
+    for(int i=0;i<g->player_count;i++) pthread_mutex_lock(&g->hand_mtx[i]);
+    rec->table_id = g->table_id;
+    rec->version = (uint32_t)g->version;
+    rec->history_count = g->history_count;
+    rec->seats = (uint8_t)tbl->seats;
+    rec->human_seat = (int8_t)tbl->human_seat;
+    rec->turn = g->turn;
+    rec->finished = (uint8_t)g->finished;
+    rec->winner = g->winner;
+    rec->blocked = (uint8_t)g->blocked;
+    rec->passes_in_row = g->passes_in_row;
+    rec->left_end = g->left_end;
+    rec->right_end = g->right_end;
+    int n = 0;
+    for(int i=0;i<g->player_count;i++){
+        rec->hand_len[i] = g->hand_len[i];
+        memcpy(&rec->tiles[n], g->hands[i], sizeof(tile_t)*g->hand_len[i]);
+        n += g->hand_len[i];
     }
+    int pool = pool_count(g);
+    rec->pool_len = (uint8_t)pool;
+    memcpy(&rec->tiles[n], g->pool, sizeof(tile_t)*pool);
+    n += pool;
+    rec->train_len = g->train_len;
+    memcpy(&rec->tiles[n], g->train, sizeof(tile_t)*g->train_len);
+    memcpy(rec->history, g->history, sizeof(rec->history));
+    for(int i=g->player_count-1;i>=0;i--) pthread_mutex_unlock(&g->hand_mtx[i]);
+    pthread_mutex_unlock(&g->mtx);
 
-    int deck_pos = 0;
-    for(int pid = 0; pid < player_count; ++pid){
-        for(int j = 0; j < 7 && deck_pos < deck_len; ++j){
-            g->hands[pid][j] = deck[deck_pos++];
-        }
-        g->hand_len[pid] = 7;
+    for(int i=0;i<tbl->seats;i++){
+        pcb_t *p = &tbl->pcbs[i];
+        pthread_mutex_lock(&p->mtx);
+        rec->pcb[i].st = (uint8_t)p->st;
+        rec->pcb[i].quantum_ms = p->quantum_ms;
+        rec->pcb[i].burst_ewma_ms = p->burst_ewma_ms;
+        pthread_mutex_unlock(&p->mtx);
     }
+}
 
-    for(int pid = player_count; pid < MAX_PLAYERS; ++pid){
-        g->hand_len[pid] = 0;
+static int pip_ok(const domino_set_t *set, int pip){ return pip >= 0 && pip <= set->max_pip; }
+
+// Comprueba que el registro describa una partida posible de este juego: cada
+// ficha del juego exactamente una vez entre manos, pozo y tren (y con pips en
+// rango), el tren encadenado con sus extremos, y turno, ganador, historial y
+// PCBs dentro de sus rangos. table_id tiene que ser el índice t del registro:
+// la cola de movimientos reparte las jugadas por mesa. Una mesa en curso tiene
+// turno y no tiene ganador; una terminada, ganador. No mira el estado en vivo:
+// sirve antes de tocarlo.
+static int ckpt_record_valid(const domino_set_t *set, const ckpt_table_t *rec, int t){
+    int players = rec->seats;
+    int deal = set_deal(set, players);
+    if(deal <= 0 || rec->table_id != t) return 0;
+    if(rec->turn < -1 || rec->turn >= players || rec->human_seat < -1 || rec->human_seat >= players) return 0;
+    if(rec->winner < -1 || rec->winner >= players || rec->finished > 1 || rec->blocked > 1) return 0;
+    if(rec->finished ? rec->winner < 0 : (rec->turn < 0 || rec->winner != -1 || rec->blocked)) return 0;
+    if(rec->passes_in_row > players) return 0;
+
+    int n = 0;
+    for(int i=0;i<players;i++){
+        if(rec->pcb[i].st > TERMINATED) return 0;
+        n += rec->hand_len[i];
     }
+    if(n + rec->pool_len + rec->train_len != set->tiles || rec->pool_len > set->tiles - deal*players) return 0;
 
-    while(deck_pos < deck_len && g->pool_len < MAX_TILES){
-        g->pool[g->pool_len++] = deck[deck_pos++];
+    // Índice de la ficha {lo,hi} con lo <= hi: hi*(hi+1)/2 + lo, de 0 a tiles-1.
+    uint8_t seen[MAX_TILES] = {0};
+    for(int i=0;i<set->tiles;i++){
+        tile_t t = rec->tiles[i];
+        if(!pip_ok(set, t.a) || !pip_ok(set, t.b)) return 0;
+        int lo = t.a < t.b ? t.a : t.b, hi = t.a < t.b ? t.b : t.a;
+        if(seen[hi*(hi+1)/2 + lo]++) return 0;
     }
 
-    int start_pid = -1;
-    int start_idx = -1;
-    tile_t start_tile = {0, 0};
-    int best_double = -1;
-    for(int pid = 0; pid < player_count; ++pid){
-        for(int j = 0; j < g->hand_len[pid]; ++j){
-            tile_t t = g->hands[pid][j];
+    const tile_t *train = &rec->tiles[n + rec->pool_len];
+    if(rec->train_len == 0){
+        if(rec->left_end != -1 || rec->right_end != -1) return 0;
+    }else{
+        if(!pip_ok(set, rec->left_end) || !pip_ok(set, rec->right_end)) return 0;
+        if(train[0].a != rec->left_end || train[rec->train_len-1].b != rec->right_end) return 0;
+        for(int i=1;i<rec->train_len;i++){
+            if(train[i-1].b != train[i].a) return 0;
+        }
+    }
+
+    // Solo las últimas HISTORY_CAP jugadas siguen en el anillo.
+    uint32_t live = rec->history_count < HISTORY_CAP ? rec->history_count : HISTORY_CAP;
+    for(uint32_t k=rec->history_count-live;k<rec->history_count;k++){
+        const hist_move_t *h = &rec->history[k % HISTORY_CAP];
+        if(h->player_id >= players) return 0;
+        int ok = (h->side == 0) ? (h->t.a == -1 && h->t.b == -1)
+                                : ((h->side == -1 || h->side == 1) && pip_ok(set, h->t.a) && pip_ok(set, h->t.b));
+        if(!ok) return 0;
+    }
+    return 1;
+}
+
+// Reconstruye la mesa t desde su registro (mapeado o en memoria) después de
+// validarlo con ckpt_record_valid. Devuelve 0 si el registro es inconsistente.
+static int restore_game_state(game_state_t *g, const domino_set_t *set, const ckpt_table_t *rec, int t){
+    if(!ckpt_record_valid(set, rec, t)) return 0;
+    int players = rec->seats;
+    g->set = set;
+    if(!layout_game_storage(g, players, set_deal(set, players))) return 0;
+
+    for(int i=0;i<players;i++){
+        if(rec->hand_len[i] > g->hand_cap) return 0;
+    }
+
+    g->table_id = t;
+    g->player_count = (int8_t)players;
+    g->human_player = rec->human_seat;
+    g->finished = (int8_t)rec->finished;
+    g->turn = rec->turn;
+    g->winner = rec->winner;
+    g->blocked = (int8_t)rec->blocked;
+    g->passes_in_row = rec->passes_in_row;
+    g->left_end = rec->left_end;
+    g->right_end = rec->right_end;
+    g->version = rec->version;
+    g->history_count = rec->history_count;
+    memcpy(g->history, rec->history, sizeof(g->history));
+    atomic_store(&g->applied_push_ns, 0);
+    atomic_store(&g->applied_ns, 0);
+
+    int n = 0;
+    for(int i=0;i<MAX_PLAYERS;i++) g->hand_len[i] = 0;
+    for(int i=0;i<players;i++){
+        g->hand_len[i] = rec->hand_len[i];
+        memcpy(g->hands[i], &rec->tiles[n], sizeof(tile_t)*rec->hand_len[i]);
+        n += rec->hand_len[i];
+    }
+    memcpy(g->pool, &rec->tiles[n], sizeof(tile_t)*rec->pool_len);
+    n += rec->pool_len;
+    atomic_store_explicit(&g->pool_top, rec->pool_len, memory_order_release);
+    g->train_len = rec->train_len;
+    memcpy(g->train, &rec->tiles[n], sizeof(tile_t)*rec->train_len);
+    publish_view(g);
+    return 1;
+}
+
+// Escribe todas las mesas en path (vía path.tmp + fsync + rename, así un corte
+// a mitad deja el checkpoint anterior). Devuelve los bytes escritos o -1.
+static long write_checkpoint(const char *path, table_runtime_t *tables, int count){
+    size_t rec_size = ckpt_record_size(cfg.set);
+    ckpt_table_t *rec = malloc(rec_size);
+    char tmp[512];
+    snprintf(tmp, sizeof(tmp), "%s.tmp", path);
+    FILE *f = rec ? fopen(tmp, "wb") : NULL;
+    if(!f){
+        free(rec);
+        return -1;
+    }
+    setvbuf(f, NULL, _IOFBF, 1 << 20);
+    ckpt_header_t h = { .version = CKPT_VERSION, .byte_order = CKPT_BYTE_ORDER,
+                        .header_size = sizeof(ckpt_header_t), .record_size = (uint32_t)rec_size,
+                        .table_count = (uint32_t)count, .max_pip = cfg.set->max_pip };
+    memcpy(h.magic, CKPT_MAGIC, sizeof(h.magic));
+    int ok = fwrite(&h, sizeof(h), 1, f) == 1;
+    for(int t=0;t<count && ok;t++){
+        memset(rec, 0, rec_size);
+        snapshot_table(&tables[t], rec);
+        ok = fwrite(rec, rec_size, 1, f) == 1;
+    }
+    ok = ok && fflush(f) == 0 && fsync(fileno(f)) == 0;
+    ok = (fclose(f) == 0) && ok;
+    free(rec);
+    if(!ok || rename(tmp, path) != 0){
+        unlink(tmp);
+        return -1;
+    }
+    return (long)(sizeof(h) + rec_size*(size_t)count);
+}
+
+// Mapea el checkpoint y valida cabecera, juego y tamaño. Fija cfg.set al juego
+// del archivo. Devuelve la cabecera mapeada (liberar con munmap) o NULL.
+static const ckpt_header_t *map_checkpoint(const char *path, size_t *out_len){
+    int fd = open(path, O_RDONLY);
+    if(fd < 0){
+        fprintf(stderr, "No se pudo abrir el checkpoint %s: %s\n", path, strerror(errno));
+        return NULL;
+    }
+    struct stat st;
+    if(fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(ckpt_header_t)){
+        fprintf(stderr, "Checkpoint %s vacío o ilegible.\n", path);
+        close(fd);
+        return NULL;
+    }
+    void *map = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if(map == MAP_FAILED){
+        fprintf(stderr, "No se pudo mapear %s: %s\n", path, strerror(errno));
+        return NULL;
+    }
+    madvise(map, (size_t)st.st_size, MADV_SEQUENTIAL);
+    const ckpt_header_t *h = map;
+    const domino_set_t *set = find_domino_set(h->max_pip);
+    const char *err = NULL;
+    if(memcmp(h->magic, CKPT_MAGIC, sizeof(h->magic)) != 0) err = "no es un checkpoint";
+    else if(h->byte_order != CKPT_BYTE_ORDER) err = "orden de bytes distinto";
+    else if(h->version != CKPT_VERSION) err = "versión no soportada";
+    else if(h->header_size != sizeof(ckpt_header_t) || !set || h->record_size != ckpt_record_size(set)) err = "formato de registro distinto";
+    else if(h->table_count < 1 || (size_t)st.st_size < h->header_size + (size_t)h->record_size*h->table_count) err = "archivo truncado";
+    if(err){
+        fprintf(stderr, "Checkpoint %s inválido: %s.\n", path, err);
+        munmap(map, (size_t)st.st_size);
+        return NULL;
+    }
+    cfg.set = set;
+    *out_len = (size_t)st.st_size;
+    return h;
+}
+
+/* ===== Ciclo de vida de mesas ===== */
+// Reserva y reparte la mesa t sin lanzar hilos: estado, PCBs y contextos.
+// tbl->seats debe estar fijado; los primeros remote_seats asientos los ocupan
+// clientes del servidor de sockets. Solo la mesa con humano tiene buzón. Con
+// from != NULL la mesa se restaura de un checkpoint en lugar de repartirse.
+// Con --exec coro reserva las pilas de las corrutinas en lugar de los hilos.
+static int prepare_table(table_runtime_t *tbl, int t, int human_seat, int remote_seats, const ckpt_table_t *from){
+    int coro = (cfg.exec_mode == EXEC_CORO);
+    tbl->pcbs = calloc(tbl->seats, sizeof(pcb_t));
+    tbl->pctx = calloc(tbl->seats, sizeof(player_ctx_t));
+    tbl->player_threads = coro ? NULL : calloc(tbl->seats, sizeof(pthread_t));
+    tbl->inbox = (human_seat >= 0) ? malloc(sizeof(human_inbox_t)) : NULL;
+    tbl->coro = coro ? calloc(1, sizeof(coro_table_t)) : NULL;
+    if(tbl->coro) tbl->coro->stacks = malloc((size_t)tbl->seats * CORO_STACK);
+    if(!tbl->pcbs || !tbl->pctx || (!coro && !tbl->player_threads) || (human_seat >= 0 && !tbl->inbox)
+       || (coro && (!tbl->coro || !tbl->coro->stacks))){
+        return 0;
+    }
+
+    tbl->human_seat = human_seat;
+    if(tbl->inbox) inbox_init(tbl->inbox);
+    tbl->state = (game_state_t){0};
+    init_game_locks(&tbl->state);
+    if(from ? !restore_game_state(&tbl->state, cfg.set, from, t)
+            : !setup_game_state(&tbl->state, cfg.set, t, tbl->seats, human_seat, NULL)){
+        return 0;
+    }
+    tbl->state.metrics = (t < metrics_table_count) ? &metrics_tables[t] : NULL;
+
+    for(int i=0;i<tbl->seats;i++){
+        tbl->pcbs[i].pid=i;
+        tbl->pcbs[i].st=READY;
+        tbl->pcbs[i].pol=RR;
+        tbl->pcbs[i].can_run = 0;
+        pcb_init_quantum(&tbl->pcbs[i], from ? from->pcb[i].quantum_ms : cfg.quantum_ms);
+        if(from){
+            tbl->pcbs[i].st = (from->pcb[i].st == RUNNING) ? READY : (pstate_t)from->pcb[i].st;
+            tbl->pcbs[i].burst_ewma_ms = from->pcb[i].burst_ewma_ms;
+        }
+        pthread_mutex_init(&tbl->pcbs[i].mtx,NULL);
+        pthread_cond_init(&tbl->pcbs[i].run_cv,NULL);
+        pthread_condattr_t attr;
+        pthread_condattr_init(&attr);
+        pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+        pthread_cond_init(&tbl->pcbs[i].yield_cv, &attr);
+        pthread_condattr_destroy(&attr);
+        tbl->pctx[i] = (player_ctx_t){ .id=i, .g=&tbl->state, .pcb=&tbl->pcbs[i], .is_human=(i==human_seat),
+                                       .is_remote=(i<remote_seats), .inbox=tbl->inbox,
+                                       .strategy = cfg.bot_count ? cfg.bots[i % cfg.bot_count] : &BOT_STRATEGIES[0],
+                                       .rng = rng_seed(((uint64_t)time(NULL) << 20) ^ (uint64_t)(t*MAX_PLAYERS + i)),
+                                       .coro = tbl->coro };
+    }
+    return 1;
+}
+
+// Lanza jugadores, validador y planificador de una mesa ya preparada, o su
+// único hilo con --exec coro. Con --sched wheel el planificador no tiene hilo:
+// es un temporizador de la rueda compartida.
+static void launch_table(table_runtime_t *tbl, int t){
+    if(tbl->coro){
+        pthread_create(&tbl->runner_thread, NULL, table_thread, tbl);
+        placement_apply(tbl->runner_thread, t);
+        return;
+    }
+    tbl->scheduler_ctx = (sched_ctx_t){ .pcbs=tbl->pcbs, .n=tbl->seats, .pol=RR, .quantum_ms=cfg.quantum_ms, .game=&tbl->state,
+                                        .burst_turn = -1, .slice_turn = -1 };
+    if(cfg.sched_wheel){
+        for(int i=0;i<tbl->seats;i++) tbl->pcbs[i].wheel = &tbl->scheduler_ctx.timer;
+        tbl->state.sched_wheel = &tbl->scheduler_ctx.timer;
+    }
+
+    for(int i=0;i<tbl->seats;i++){
+        pthread_create(&tbl->player_threads[i], NULL, player_thread, &tbl->pctx[i]);
+    }
+
+    pthread_create(&tbl->validator_thread, NULL, validator_thread, &tbl->state);
+
+    if(cfg.sched_wheel){
+        wheel_arm(&tbl->scheduler_ctx.timer, sched_wheel_fire, &tbl->scheduler_ctx, 0);
+    }else{
+        pthread_create(&tbl->scheduler_thread, NULL, scheduler_thread, &tbl->scheduler_ctx);
+    }
+
+    // Jugadores, validador y planificador comparten game_state_t: misma ubicación.
+    for(int i=0;i<tbl->seats;i++){
+        placement_apply(tbl->player_threads[i], t);
+    }
+    placement_apply(tbl->validator_thread, t);
+    if(!cfg.sched_wheel) placement_apply(tbl->scheduler_thread, t);
+}
+
+// Prepara la mesa t y lanza jugadores, validador y planificador.
+static int start_table(table_runtime_t *tbl, int t, int human_seat, int remote_seats){
+    if(!prepare_table(tbl, t, human_seat, remote_seats, NULL)) return 0;
+    launch_table(tbl, t);
+    return 1;
+}
+
+static void join_table(table_runtime_t *tbl){
+    if(tbl->coro){
+        pthread_join(tbl->runner_thread, NULL);
+        return;
+    }
+    if(cfg.sched_wheel) wheel_wait_done(&tbl->scheduler_ctx.timer);
+    else pthread_join(tbl->scheduler_thread, NULL);
+    pthread_join(tbl->validator_thread, NULL);
+    for(int i=0;i<tbl->seats;i++){
+        pthread_join(tbl->player_threads[i], NULL);
+    }
+}
+
+static void report_table_result(table_runtime_t *tbl){
+    int t = tbl->state.table_id;
+    int winner = tbl->state.winner;
+    int blocked = tbl->state.blocked;
+    int player_count = tbl->state.player_count;
+    int human_id = tbl->state.human_player;
+    int scores[MAX_PLAYERS] = {0};
+    for(int i=0;i<player_count;i++){
+        scores[i] = compute_hand_points(&tbl->state, i);
+    }
+    if(winner >= 0){
+        printf("Ganador mesa %d: Jugador %d%s (%s).\n", t+1, winner+1, (winner==human_id)?" (Humano)":"", blocked?"bloqueo":"mano limpia");
+    }else{
+        printf("Mesa %d finalizada sin ganador registrado.\n", t+1);
+    }
+    printf("Puntajes finales: ");
+    for(int i=0;i<player_count;i++){
+        printf("J%d=%d%s", i+1, scores[i], (i==player_count-1)?"":" | ");
+    }
+    printf("\n");
+}
+
+// Ráfaga estimada y cuantums recientes de cada asiento, y la espera del
+// planificador ahorrada en las porciones vencidas frente al cuantum fijo.
+static void print_quantum_report(table_runtime_t *tbl){
+    long saved_us = tbl->state.metrics
+                  ? atomic_load_explicit(&tbl->state.metrics->scheduler.idle_saved_us, memory_order_relaxed) : 0;
+    printf("Cuantum mesa %d (referencia %d ms, límites %d-%d ms): espera ahorrada en porciones vencidas %.1f ms\n", tbl->state.table_id+1,
+           cfg.quantum_ms, cfg.quantum_min_ms, cfg.quantum_max_ms, saved_us/1000.0);
+    for(int i=0;i<tbl->seats;i++){
+        const pcb_t *p = &tbl->pcbs[i];
+        printf("  J%d: ráfaga EWMA ", i+1);
+        if(p->burst_ewma_ms < 0) printf("-");
+        else printf("%.3f ms", p->burst_ewma_ms);
+        printf(", %d cambios, cuantums:", p->q_changes - 1);
+        int first = p->q_changes > Q_HIST_LEN ? p->q_changes - Q_HIST_LEN : 0;
+        for(int k=first;k<p->q_changes;k++){
+            printf("%s%d", (k==first)?" ":"→", p->q_hist[k % Q_HIST_LEN]);
+        }
+        printf(" ms\n");
+    }
+}
+
+static void destroy_table(table_runtime_t *tbl){
+    for(int i=0;i<tbl->seats;i++){
+        pthread_mutex_destroy(&tbl->pcbs[i].mtx);
+        pthread_cond_destroy(&tbl->pcbs[i].run_cv);
+        pthread_cond_destroy(&tbl->pcbs[i].yield_cv);
+    }
+    destroy_game_locks(&tbl->state);
+    if(tbl->inbox){
+        inbox_destroy(tbl->inbox);
+        free(tbl->inbox);
+    }
+    release_game_state(&tbl->state);
+    free(tbl->pcbs);
+    free(tbl->pctx);
+    free(tbl->player_threads);
+    if(tbl->coro){
+        free(tbl->coro->stacks);
+        free(tbl->coro);
+    }
+}
+
+/* ===== Servidor de sockets ===== */
+// Un único hilo con epoll atiende todas las conexiones (Unix o TCP en loopback).
+// Protocolo de líneas, mesas y asientos numerados desde 1:
+//   cliente  -> JOIN <mesa|*> | j <a> <b> <i|d> | c | p | QUIT
+//   servidor -> OK <mesa> <asiento> | E <motivo>
+//               S <mesa> <asiento> <turno> <izq> <der> <pozo> <n> a:b ...
+//               F <mesa> <ganador> <bloqueo>
+// Las jugadas validadas entran en la cola de movimientos como las de un bot;
+// el validador avisa por eventfd qué mesas cambiaron para enviar su estado.
+#define CONN_BUF 4096
+
+typedef enum { EP_LISTEN, EP_NOTIFY, EP_CLIENT } ep_kind_t;
+
+typedef struct conn_t {
+    ep_kind_t kind;
+    int fd;
+    int table, seat;              // -1 hasta JOIN
+    char in[256]; size_t in_len;
+    char out[CONN_BUF]; size_t out_len;
+    int want_out;
+    int dead;
+    struct conn_t *next_dead;
+} conn_t;
+
+typedef struct {
+    int ep_fd;
+    conn_t listen_ep, notify_ep;
+    table_runtime_t *tables; int table_count;
+    int remote_seats;
+    conn_t **seat_conn;           // [mesa*MAX_PLAYERS + asiento], solo del hilo servidor
+    int join_cursor;
+    conn_t *dead_list;
+    pthread_mutex_t dirty_mtx;
+    char *dirty; int *dirty_list; int *drain_list; int dirty_n;
+    atomic_int stop;
+    long connections, moves_received, updates_sent, dropped;
+} server_t;
+
+static server_t *game_server; // activo solo con --serve
+
+static void server_notify_table(int table_id){
+    server_t *sv = game_server;
+    if(!sv) return;
+    int wake = 0;
+    pthread_mutex_lock(&sv->dirty_mtx);
+    if(!sv->dirty[table_id]){
+        sv->dirty[table_id] = 1;
+        wake = (sv->dirty_n == 0);
+        sv->dirty_list[sv->dirty_n++] = table_id;
+    }
+    pthread_mutex_unlock(&sv->dirty_mtx);
+    if(wake){
+        uint64_t one = 1;
+        ssize_t r = write(sv->notify_ep.fd, &one, sizeof(one));
+        (void)r;
+    }
+}
+
+// "unix:/ruta" o "tcp:PUERTO" (siempre 127.0.0.1).
+static int parse_sock_addr(const char *spec, struct sockaddr_storage *ss, socklen_t *len){
+    memset(ss, 0, sizeof(*ss));
+    if(strncmp(spec, "unix:", 5) == 0){
+        struct sockaddr_un *un = (struct sockaddr_un*)ss;
+        if(strlen(spec+5) >= sizeof(un->sun_path)) return 0;
+        un->sun_family = AF_UNIX;
+        strcpy(un->sun_path, spec+5);
+        *len = sizeof(*un);
+        return 1;
+    }
+    if(strncmp(spec, "tcp:", 4) == 0){
+        struct sockaddr_in *in = (struct sockaddr_in*)ss;
+        int port = atoi(spec+4);
+        if(port <= 0 || port > 65535) return 0;
+        in->sin_family = AF_INET;
+        in->sin_port = htons((uint16_t)port);
+        in->sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        *len = sizeof(*in);
+        return 1;
+    }
+    return 0;
+}
+
+static int set_nonblocking(int fd){
+    int fl = fcntl(fd, F_GETFL, 0);
+    return (fl < 0) ? -1 : fcntl(fd, F_SETFL, fl | O_NONBLOCK);
+}
+
+// Miles de conexiones superan el límite por defecto de descriptores.
+static void raise_fd_limit(void){
+    struct rlimit rl;
+    if(getrlimit(RLIMIT_NOFILE, &rl) == 0 && rl.rlim_cur < rl.rlim_max){
+        rl.rlim_cur = rl.rlim_max;
+        setrlimit(RLIMIT_NOFILE, &rl);
+    }
+}
+
+static int open_listener(const char *spec){
+    struct sockaddr_storage ss; socklen_t len;
+    if(!parse_sock_addr(spec, &ss, &len)) return -1;
+    int fd = socket(ss.ss_family, SOCK_STREAM, 0);
+    if(fd < 0) return -1;
+    if(ss.ss_family == AF_UNIX){
+        unlink(((struct sockaddr_un*)&ss)->sun_path);
+    }else{
+        int on = 1;
+        setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+    }
+    if(bind(fd, (struct sockaddr*)&ss, len) < 0 || listen(fd, SOMAXCONN) < 0 || set_nonblocking(fd) < 0){
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+static void server_kill_conn(server_t *sv, conn_t *c){
+    if(c->dead) return;
+    c->dead = 1;
+    if(c->table >= 0) sv->seat_conn[c->table*MAX_PLAYERS + c->seat] = NULL;
+    epoll_ctl(sv->ep_fd, EPOLL_CTL_DEL, c->fd, NULL);
+    close(c->fd);
+    c->next_dead = sv->dead_list;
+    sv->dead_list = c;
+}
+
+static void server_reap(server_t *sv){
+    while(sv->dead_list){
+        conn_t *c = sv->dead_list;
+        sv->dead_list = c->next_dead;
+        free(c);
+    }
+}
+
+static void conn_flush(server_t *sv, conn_t *c){
+    while(c->out_len > 0){
+        ssize_t n = send(c->fd, c->out, c->out_len, MSG_NOSIGNAL);
+        if(n < 0){
+            if(errno == EINTR) continue;
+            if(errno != EAGAIN && errno != EWOULDBLOCK) server_kill_conn(sv, c);
+            break;
+        }
+        memmove(c->out, c->out + n, c->out_len - (size_t)n);
+        c->out_len -= (size_t)n;
+    }
+    if(c->dead) return;
+    int want = (c->out_len > 0);
+    if(want != c->want_out){
+        struct epoll_event ev = { .events = EPOLLIN | (want ? EPOLLOUT : 0), .data.ptr = c };
+        epoll_ctl(sv->ep_fd, EPOLL_CTL_MOD, c->fd, &ev);
+        c->want_out = want;
+    }
+}
+
+static void conn_printf(server_t *sv, conn_t *c, const char *fmt, ...){
+    if(c->dead) return;
+    va_list ap;
+    va_start(ap, fmt);
+    int n = vsnprintf(c->out + c->out_len, CONN_BUF - c->out_len, fmt, ap);
+    va_end(ap);
+    if(n < 0 || (size_t)n >= CONN_BUF - c->out_len){
+        // Cliente que no lee: se corta antes que acumular estados viejos.
+        sv->dropped++;
+        server_kill_conn(sv, c);
+        return;
+    }
+    c->out_len += (size_t)n;
+    conn_flush(sv, c);
+}
+
+static void server_send_state(server_t *sv, conn_t *c){
+    game_state_t *g = &sv->tables[c->table].state;
+    char buf[CONN_BUF/2];
+    int n;
+    // winner/blocked se escriben antes de publicar finished en la vista.
+    table_view_t v = load_view(g);
+    if(v.finished){
+        n = snprintf(buf, sizeof(buf), "F %d %d %d\n", c->table+1, g->winner+1, g->blocked);
+    }else{
+        pthread_mutex_lock(&g->hand_mtx[c->seat]);
+        n = snprintf(buf, sizeof(buf), "S %d %d %d %d %d %d %d", c->table+1, c->seat+1, v.turn+1,
+                     v.left, v.right, pool_count(g), g->hand_len[c->seat]);
+        for(int i=0;i<g->hand_len[c->seat] && n < (int)sizeof(buf)-8;i++){
+            n += snprintf(buf+n, sizeof(buf)-n, " %d:%d", g->hands[c->seat][i].a, g->hands[c->seat][i].b);
+        }
+        pthread_mutex_unlock(&g->hand_mtx[c->seat]);
+        n += snprintf(buf+n, sizeof(buf)-n, "\n");
+    }
+    sv->updates_sent++;
+    conn_printf(sv, c, "%s", buf);
+}
+
+static void server_join(server_t *sv, conn_t *c, const char *arg){
+    if(c->table >= 0){
+        conn_printf(sv, c, "E ya ocupa un asiento\n");
+        return;
+    }
+    int want = -1;
+    if(arg[0] != '*') want = atoi(arg) - 1;
+    int first = (want >= 0) ? want : sv->join_cursor;
+    int last  = (want >= 0) ? want + 1 : sv->table_count;
+    if(want >= sv->table_count) first = last = 0;
+    for(int t=first;t<last;t++){
+        table_runtime_t *tbl = &sv->tables[t];
+        if(load_view(&tbl->state).finished) continue;
+        int seats = sv->remote_seats < tbl->seats ? sv->remote_seats : tbl->seats;
+        for(int s=0;s<seats;s++){
+            if(sv->seat_conn[t*MAX_PLAYERS + s]) continue;
+            sv->seat_conn[t*MAX_PLAYERS + s] = c;
+            c->table = t;
+            c->seat = s;
+            if(want < 0) sv->join_cursor = t;
+            conn_printf(sv, c, "OK %d %d\n", t+1, s+1);
+            server_send_state(sv, c);
+            return;
+        }
+    }
+    conn_printf(sv, c, "E no hay asientos libres\n");
+}
+
+// Mismas reglas que el turno humano; la jugada válida va a la cola del validador.
+static void server_play(server_t *sv, conn_t *c, const char *line){
+    game_state_t *g = &sv->tables[c->table].state;
+    int pid = c->seat;
+    char opt = 0, side_c = 0;
+    int a = -1, b = -1;
+    sscanf(line, " %c %d %d %c", &opt, &a, &b, &side_c);
+    opt = tolower((unsigned char)opt);
+
+    table_view_t v = load_view(g);
+    if(v.finished || v.turn != pid){
+        conn_printf(sv, c, "E no es su turno\n");
+        return;
+    }
+    const char *err = NULL;
+    int send_state = 0;
+    switch(opt){
+        case 'j': {
+            int side = (side_c == 'i') ? -1 : (side_c == 'd') ? 1 : 0;
+            int idx = -1;
+            tile_t found = { .a=-1, .b=-1 };
+            pthread_mutex_lock(&g->hand_mtx[pid]);
+            for(int i=0;i<g->hand_len[pid];i++){
+                tile_t t = g->hands[pid][i];
+                if((t.a == a && t.b == b) || (t.a == b && t.b == a)){ idx = i; found = t; break; }
+            }
+            pthread_mutex_unlock(&g->hand_mtx[pid]);
+            int target = (side < 0) ? v.left : v.right;
+            if(side == 0){
+                err = "uso: j <a> <b> <i|d>";
+            }else if(idx < 0){
+                err = "la ficha no está en su mano";
+            }else if(target != -1 && a != target && b != target){
+                err = "la ficha no encaja en ese lado";
+            }else{
+                move_t mv = { .player_id = pid, .table_id = g->table_id, .t = found, .side = side };
+                // El hilo epoll atiende a todas las conexiones: nunca espera lugar en la cola.
+                if(moveq_try_push(&mv)){
+                    sv->moves_received++;
+                    pcb_yield(&sv->tables[c->table].pcbs[pid], v.version);
+                }else{
+                    err = "cola llena"; // el cliente reintenta con el estado
+                    send_state = 1;
+                }
+            }
+            break;
+        }
+        case 'c':
+            if(draw_from_pool(g, pid)) send_state = 1;
+            else err = "no quedan fichas en el pozo";
+            break;
+        case 'p': {
+            tile_t dummy; int dummy_side;
+            if(pool_count(g) > 0 || can_play(g, pid, &dummy, &dummy_side)){
+                err = "no puede pasar";
+            }else{
+                move_t mv = { .player_id = pid, .table_id = g->table_id, .t = { .a=-1, .b=-1 }, .side = 0 };
+                if(moveq_try_push(&mv)){
+                    sv->moves_received++;
+                    pcb_yield(&sv->tables[c->table].pcbs[pid], v.version);
+                }else{
+                    err = "cola llena";
+                    send_state = 1;
+                }
+            }
+            break;
+        }
+        default:
+            err = "comando no reconocido";
+            break;
+    }
+    if(err) conn_printf(sv, c, "E %s\n", err);
+    if(send_state) server_send_state(sv, c);
+}
+
+static void server_handle_line(server_t *sv, conn_t *c, char *line){
+    if(strncmp(line, "JOIN", 4) == 0){
+        const char *arg = line + 4;
+        while(isspace((unsigned char)*arg)) arg++;
+        server_join(sv, c, *arg ? arg : "*");
+    }else if(strncmp(line, "QUIT", 4) == 0){
+        server_kill_conn(sv, c);
+    }else if(c->table < 0){
+        conn_printf(sv, c, "E primero JOIN <mesa|*>\n");
+    }else{
+        server_play(sv, c, line);
+    }
+}
+
+static void server_read(server_t *sv, conn_t *c){
+    while(!c->dead){
+        ssize_t n = recv(c->fd, c->in + c->in_len, sizeof(c->in) - 1 - c->in_len, 0);
+        if(n == 0 || (n < 0 && errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR)){
+            server_kill_conn(sv, c);
+            return;
+        }
+        if(n < 0){
+            if(errno == EINTR) continue;
+            return;
+        }
+        c->in_len += (size_t)n;
+        char *start = c->in, *nl;
+        while(!c->dead && (nl = memchr(start, '\n', c->in + c->in_len - start))){
+            *nl = '\0';
+            if(nl > start && nl[-1] == '\r') nl[-1] = '\0';
+            server_handle_line(sv, c, start);
+            start = nl + 1;
+        }
+        if(c->dead) return;
+        c->in_len -= (size_t)(start - c->in);
+        memmove(c->in, start, c->in_len);
+        if(c->in_len >= sizeof(c->in) - 1) c->in_len = 0; // línea sin fin: se descarta
+    }
+}
+
+static void server_accept(server_t *sv){
+    while(1){
+        int fd = accept(sv->listen_ep.fd, NULL, NULL);
+        if(fd < 0) return;
+        conn_t *c = calloc(1, sizeof(conn_t));
+        if(!c || set_nonblocking(fd) < 0){
+            free(c);
+            close(fd);
+            continue;
+        }
+        int on = 1;
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &on, sizeof(on)); // falla sin efecto en sockets Unix
+        c->kind = EP_CLIENT;
+        c->fd = fd;
+        c->table = c->seat = -1;
+        struct epoll_event ev = { .events = EPOLLIN, .data.ptr = c };
+        if(epoll_ctl(sv->ep_fd, EPOLL_CTL_ADD, fd, &ev) < 0){
+            free(c);
+            close(fd);
+            continue;
+        }
+        sv->connections++;
+    }
+}
+
+static void server_drain_dirty(server_t *sv){
+    uint64_t cnt;
+    ssize_t r = read(sv->notify_ep.fd, &cnt, sizeof(cnt));
+    (void)r;
+    pthread_mutex_lock(&sv->dirty_mtx);
+    int n = sv->dirty_n;
+    memcpy(sv->drain_list, sv->dirty_list, sizeof(int)*n);
+    for(int i=0;i<n;i++) sv->dirty[sv->dirty_list[i]] = 0;
+    sv->dirty_n = 0;
+    pthread_mutex_unlock(&sv->dirty_mtx);
+    for(int i=0;i<n;i++){
+        int t = sv->drain_list[i];
+        for(int s=0;s<MAX_PLAYERS;s++){
+            conn_t *c = sv->seat_conn[t*MAX_PLAYERS + s];
+            if(c) server_send_state(sv, c);
+        }
+    }
+}
+
+static void *server_thread(void *arg){
+    server_t *sv = (server_t*)arg;
+    struct epoll_event evs[256];
+    while(1){
+        int n = epoll_wait(sv->ep_fd, evs, 256, 100);
+        for(int i=0;i<n;i++){
+            conn_t *c = (conn_t*)evs[i].data.ptr;
+            if(c->kind == EP_LISTEN){
+                server_accept(sv);
+            }else if(c->kind == EP_NOTIFY){
+                server_drain_dirty(sv);
+            }else if(!c->dead){
+                if(evs[i].events & (EPOLLERR | EPOLLHUP)){
+                    server_kill_conn(sv, c);
+                    continue;
+                }
+                if(evs[i].events & EPOLLOUT) conn_flush(sv, c);
+                if(evs[i].events & EPOLLIN) server_read(sv, c);
+            }
+        }
+        server_reap(sv);
+        if(atomic_load(&sv->stop)){
+            server_drain_dirty(sv);
+            break;
+        }
+    }
+    for(int i=0;i<sv->table_count*MAX_PLAYERS;i++){
+        if(sv->seat_conn[i]) server_kill_conn(sv, sv->seat_conn[i]);
+    }
+    server_reap(sv);
+    return NULL;
+}
+
+static int server_init(server_t *sv, table_runtime_t *tables, int table_count, const char *spec){
+    *sv = (server_t){0};
+    sv->tables = tables;
+    sv->table_count = table_count;
+    sv->remote_seats = cfg.remote_seats;
+    sv->seat_conn = calloc((size_t)table_count*MAX_PLAYERS, sizeof(conn_t*));
+    sv->dirty = calloc(table_count, 1);
+    sv->dirty_list = calloc(table_count, sizeof(int));
+    sv->drain_list = calloc(table_count, sizeof(int));
+    if(!sv->seat_conn || !sv->dirty || !sv->dirty_list || !sv->drain_list) return 0;
+    pthread_mutex_init(&sv->dirty_mtx, NULL);
+    atomic_init(&sv->stop, 0);
+
+    sv->listen_ep = (conn_t){ .kind = EP_LISTEN, .fd = open_listener(spec) };
+    sv->notify_ep = (conn_t){ .kind = EP_NOTIFY, .fd = eventfd(0, EFD_NONBLOCK) };
+    sv->ep_fd = epoll_create1(0);
+    if(sv->listen_ep.fd < 0 || sv->notify_ep.fd < 0 || sv->ep_fd < 0) return 0;
+    struct epoll_event ev = { .events = EPOLLIN, .data.ptr = &sv->listen_ep };
+    epoll_ctl(sv->ep_fd, EPOLL_CTL_ADD, sv->listen_ep.fd, &ev);
+    ev.data.ptr = &sv->notify_ep;
+    epoll_ctl(sv->ep_fd, EPOLL_CTL_ADD, sv->notify_ep.fd, &ev);
+    return 1;
+}
+
+static void server_destroy(server_t *sv, const char *spec){
+    if(sv->listen_ep.fd >= 0) close(sv->listen_ep.fd);
+    if(sv->notify_ep.fd >= 0) close(sv->notify_ep.fd);
+    if(sv->ep_fd >= 0) close(sv->ep_fd);
+    if(strncmp(spec, "unix:", 5) == 0) unlink(spec+5);
+    pthread_mutex_destroy(&sv->dirty_mtx);
+    free(sv->seat_conn);
+    free(sv->dirty);
+    free(sv->dirty_list);
+    free(sv->drain_list);
+}
+
+// Modo --serve: mesas sin configuración interactiva; los primeros
+// --remote-seats asientos de cada mesa esperan clientes, el resto son bots.
+static int run_server(void){
+    raise_fd_limit();
+    int tables_count = cfg.tables;
+    table_runtime_t *tables = calloc(tables_count, sizeof(table_runtime_t));
+    if(!tables){
+        fprintf(stderr, "Error al reservar memoria para las mesas.\n");
+        return 1;
+    }
+    static server_t sv;
+    if(!server_init(&sv, tables, tables_count, cfg.serve_addr)){
+        fprintf(stderr, "No se pudo abrir el servidor en %s.\n", cfg.serve_addr);
+        return 1;
+    }
+    game_server = &sv;
+    pthread_t srv_thread;
+    pthread_create(&srv_thread, NULL, server_thread, &sv);
+
+    if(!moveq_init(cfg.queue_cap, tables_count) || !metrics_init(tables_count)){
+        fprintf(stderr, "Error al reservar memoria para las métricas.\n");
+        return 1;
+    }
+    for(int t=0;t<tables_count;t++){
+        table_runtime_t *tbl = &tables[t];
+        tbl->seats = cfg.players ? cfg.players : rand()%3 + 2;
+        if(!start_table(tbl, t, -1, sv.remote_seats)){
+            fprintf(stderr, "Error al preparar la mesa %d.\n", t+1);
+            return 1;
+        }
+    }
+    if(sv.remote_seats >= MAX_PLAYERS){
+        printf("Servidor en %s: %d mesas, todos los asientos remotos.\n", cfg.serve_addr, tables_count);
+    }else{
+        printf("Servidor en %s: %d mesas, %d asientos remotos por mesa.\n", cfg.serve_addr, tables_count, sv.remote_seats);
+    }
+    fflush(stdout);
+
+    // Sin volcado de mesas en consola (salvo --dashboard): el reporter exporta
+    // métricas y atiende SIGUSR1 con los percentiles de latencia.
+    reporter_ctx_t rep_ctx = { .tables = tables, .table_count = tables_count, .interval_ms = 500, .quiet = !cfg.dashboard };
+    pthread_t rep_thread;
+    pthread_create(&rep_thread, NULL, reporter_thread, &rep_ctx);
+
+    long t0 = now_ms();
+    for(int t=0;t<tables_count;t++){
+        join_table(&tables[t]);
+    }
+    long elapsed = now_ms() - t0;
+    pthread_join(rep_thread, NULL);
+
+    atomic_store(&sv.stop, 1);
+    server_notify_table(0);
+    pthread_join(srv_thread, NULL);
+    game_server = NULL;
+
+    int blocked = 0;
+    long saved_us = 0;
+    for(int t=0;t<tables_count;t++){
+        blocked += tables[t].state.blocked;
+        saved_us += atomic_load_explicit(&metrics_tables[t].scheduler.idle_saved_us, memory_order_relaxed);
+        destroy_table(&tables[t]);
+    }
+    free(tables);
+    printf("Mesas terminadas: %d (%d por bloqueo) en %ld ms\n", tables_count, blocked, elapsed);
+    printf("Conexiones: %ld | jugadas recibidas: %ld | estados enviados: %ld | clientes cortados: %ld\n",
+           sv.connections, sv.moves_received, sv.updates_sent, sv.dropped);
+    printf("Cuantum adaptativo (%d-%d ms): espera ahorrada en porciones vencidas %.1f ms frente a %d ms fijos\n",
+           cfg.quantum_min_ms, cfg.quantum_max_ms, saved_us/1000.0, cfg.quantum_ms);
+    server_destroy(&sv, cfg.serve_addr);
+    print_validator_summary();
+    print_queue_summary();
+    print_latency_report();
+    metrics_free();
+    moveq_free();
+    return 0;
+}
+
+/* ===== Cliente de carga ===== */
+// Abre --conns conexiones desde un solo hilo, ocupa asientos con JOIN * y
+// responde cada turno con la primera ficha que encaja (o compra/pasa).
+// Mide la latencia de ida y vuelta de cada comando hasta la siguiente línea.
+typedef struct {
+    int fd;
+    int table, seat;
+    char in[CONN_BUF]; size_t in_len;
+    long sent_ns;
+    int done;
+} lg_conn_t;
+
+typedef struct {
+    long *rtt; size_t rtt_n, rtt_cap;
+    long requests, plays, errors;
+} lg_stats_t;
+
+static int cmp_long(const void *a, const void *b){
+    long x = *(const long*)a, y = *(const long*)b;
+    return (x > y) - (x < y);
+}
+
+static void lg_send(lg_conn_t *c, const char *msg){
+    if(send(c->fd, msg, strlen(msg), MSG_NOSIGNAL) < 0) c->done = 1;
+}
+
+static void lg_handle_line(lg_conn_t *c, char *line, lg_stats_t *st){
+    if(c->sent_ns && line[0] != 'O'){
+        if(st->rtt_n == st->rtt_cap){
+            st->rtt_cap = st->rtt_cap ? st->rtt_cap*2 : 4096;
+            long *grown = realloc(st->rtt, sizeof(long)*st->rtt_cap);
+            if(!grown) return;
+            st->rtt = grown;
+        }
+        st->rtt[st->rtt_n++] = now_ns() - c->sent_ns;
+        c->sent_ns = 0;
+    }
+    switch(line[0]){
+        case 'O':
+            sscanf(line, "OK %d %d", &c->table, &c->seat);
+            break;
+        case 'E':
+            st->errors++;
+            if(c->table < 0) c->done = 1;
+            break;
+        case 'F':
+            c->done = 1;
+            break;
+        case 'S': {
+            int table, seat, turn, left, right, pool, n, off = 0;
+            if(sscanf(line, "S %d %d %d %d %d %d %d%n", &table, &seat, &turn, &left, &right, &pool, &n, &off) < 7) break;
+            if(turn != seat) break;
+            char msg[32] = "";
+            const char *p = line + off;
+            for(int i=0;i<n && !msg[0];i++){
+                int a, b, used;
+                if(sscanf(p, " %d:%d%n", &a, &b, &used) != 2) break;
+                p += used;
+                if(left == -1 || a == left || b == left) snprintf(msg, sizeof(msg), "j %d %d i\n", a, b);
+                else if(a == right || b == right) snprintf(msg, sizeof(msg), "j %d %d d\n", a, b);
+            }
+            if(msg[0]) st->plays++;
+            else snprintf(msg, sizeof(msg), pool > 0 ? "c\n" : "p\n");
+            st->requests++;
+            c->sent_ns = now_ns();
+            lg_send(c, msg);
+            break;
+        }
+    }
+}
+
+static int run_load_client(void){
+    raise_fd_limit();
+    struct sockaddr_storage ss; socklen_t len;
+    if(!parse_sock_addr(cfg.client_addr, &ss, &len)){
+        fprintf(stderr, "Dirección inválida: %s\n", cfg.client_addr);
+        return 1;
+    }
+    int n = cfg.conns;
+    lg_conn_t *conns = calloc(n, sizeof(lg_conn_t));
+    int ep = epoll_create1(0);
+    if(!conns || ep < 0){
+        fprintf(stderr, "Error al preparar el cliente de carga.\n");
+        return 1;
+    }
+    lg_stats_t st = {0};
+    int open_conns = 0;
+    for(int i=0;i<n;i++){
+        lg_conn_t *c = &conns[i];
+        c->table = c->seat = -1;
+        c->fd = socket(ss.ss_family, SOCK_STREAM, 0);
+        if(c->fd < 0 || connect(c->fd, (struct sockaddr*)&ss, len) < 0){
+            fprintf(stderr, "Conexión %d rechazada: %s\n", i+1, strerror(errno));
+            if(c->fd >= 0) close(c->fd);
+            c->fd = -1;
+            c->done = 1;
+            continue;
+        }
+        int on = 1;
+        setsockopt(c->fd, IPPROTO_TCP, TCP_NODELAY, &on, sizeof(on));
+        set_nonblocking(c->fd);
+        struct epoll_event ev = { .events = EPOLLIN, .data.ptr = c };
+        epoll_ctl(ep, EPOLL_CTL_ADD, c->fd, &ev);
+        lg_send(c, "JOIN *\n");
+        open_conns++;
+    }
+
+    long t0 = now_ns();
+    long deadline = t0 + (long)cfg.duration_s * 1000000000L;
+    int joined = 0;
+    struct epoll_event evs[256];
+    while(open_conns > 0 && now_ns() < deadline){
+        int ne = epoll_wait(ep, evs, 256, 100);
+        for(int i=0;i<ne;i++){
+            lg_conn_t *c = (lg_conn_t*)evs[i].data.ptr;
+            if(c->done) continue;
+            ssize_t r = recv(c->fd, c->in + c->in_len, sizeof(c->in) - 1 - c->in_len, 0);
+            if(r <= 0){
+                if(r < 0 && (errno == EAGAIN || errno == EINTR)) continue;
+                c->done = 1;
+            }else{
+                c->in_len += (size_t)r;
+                char *start = c->in, *nl;
+                while(!c->done && (nl = memchr(start, '\n', c->in + c->in_len - start))){
+                    *nl = '\0';
+                    int was_joined = (c->table >= 0);
+                    lg_handle_line(c, start, &st);
+                    if(!was_joined && c->table >= 0) joined++;
+                    start = nl + 1;
+                }
+                c->in_len -= (size_t)(start - c->in);
+                memmove(c->in, start, c->in_len);
+            }
+            if(c->done){
+                epoll_ctl(ep, EPOLL_CTL_DEL, c->fd, NULL);
+                close(c->fd);
+                c->fd = -1;
+                open_conns--;
+            }
+        }
+    }
+    double secs = (now_ns() - t0) / 1e9;
+    for(int i=0;i<n;i++){
+        if(conns[i].fd >= 0) close(conns[i].fd);
+    }
+    close(ep);
+
+    qsort(st.rtt, st.rtt_n, sizeof(long), cmp_long);
+    printf("Conexiones: %d | asientos: %d | comandos: %ld | jugadas: %ld | errores: %ld\n",
+           n, joined, st.requests, st.plays, st.errors);
+    printf("Duración: %.2f s | comandos/s: %.0f | jugadas/s: %.0f\n",
+           secs, st.requests/secs, st.plays/secs);
+    if(st.rtt_n > 0){
+        printf("RTT (us): p50=%.1f p90=%.1f p99=%.1f max=%.1f\n",
+               st.rtt[st.rtt_n/2]/1e3, st.rtt[st.rtt_n*9/10]/1e3, st.rtt[st.rtt_n*99/100]/1e3, st.rtt[st.rtt_n-1]/1e3);
+    }
+    free(st.rtt);
+    free(conns);
+    return 0;
+}
+
+/* ===== Mesa en un solo hilo (--exec coro) ===== */
+// Cuerpo de cada corrutina: el mismo player_thread, que con cx->coro cede en
+// lugar de dormir. makecontext solo pasa int, de ahí el puntero en dos mitades.
+static void coro_seat_entry(unsigned hi, unsigned lo){
+    player_ctx_t *cx = (player_ctx_t*)(((uintptr_t)hi << 32) | (uintptr_t)lo);
+    player_thread(cx);
+    cx->coro->done[cx->id] = 1;
+}   // uc_link vuelve a table_thread
+
+// Despacha un asiento hasta que ceda o retorne. Mismos estados y cuantum
+// adaptativo que con scheduler_thread, pero sin porción que vencer: la ráfaga
+// solo se cierra cuando el asiento encoló.
+static void coro_dispatch(table_runtime_t *tbl, int seat, uint32_t burst_version){
+    coro_table_t *co = tbl->coro;
+    pcb_t *p = &tbl->pcbs[seat];
+    METRIC_INC(tbl->state.metrics, scheduler, dispatches);
+    pthread_mutex_lock(&p->mtx);
+    p->st = RUNNING;
+    p->can_run = 1;
+    pthread_mutex_unlock(&p->mtx);
+
+    co->wait_ms = 0;
+    swapcontext(&co->runner, &co->seat[seat]);
+
+    pthread_mutex_lock(&p->mtx);
+    if(p->burst_open && p->push_version == burst_version && p->push_ns >= p->burst_start_ns){
+        pcb_end_slice(p, p->push_ns);
+    }
+    if(p->st != TERMINATED){
+        p->can_run = 0;
+        if(p->st == RUNNING) p->st = READY;
+    }
+    pthread_mutex_unlock(&p->mtx);
+}
+
+// Planificador y validador de la mesa como pasos de un mismo bucle: despachar
+// al asiento del turno y aplicar lo que haya encolado.
+static void *table_thread(void *arg){
+    table_runtime_t *tbl = (table_runtime_t*)arg;
+    coro_table_t *co = tbl->coro;
+    game_state_t *g = &tbl->state;
+    for(int i=0;i<tbl->seats;i++){
+        uintptr_t cx = (uintptr_t)&tbl->pctx[i];
+        getcontext(&co->seat[i]);
+        co->seat[i].uc_stack.ss_sp = co->stacks + (size_t)i * CORO_STACK;
+        co->seat[i].uc_stack.ss_size = CORO_STACK;
+        co->seat[i].uc_link = &co->runner;
+        makecontext(&co->seat[i], (void (*)(void))coro_seat_entry, 2, (unsigned)(cx >> 32), (unsigned)cx);
+    }
+
+    move_t batch[MOVE_BATCH_MAX];
+    int burst_turn = -1; uint32_t burst_version = 0;
+    while(1){
+        int active = 0;
+        for(int i=0;i<tbl->seats;i++) active |= !co->done[i];
+        if(!active) break;
+
+        table_view_t v = load_view(g);
+        if(v.finished){
+            for(int i=0;i<tbl->seats;i++){
+                if(!co->done[i]) coro_dispatch(tbl, i, v.version);
+            }
+            continue;
+        }
+        if(v.turn < 0 || v.turn >= tbl->seats){
+            msleep(1);
+            continue;
+        }
+        if(co->done[v.turn]){
+            pthread_mutex_lock(&g->mtx);
+            if(!g->finished && g->turn == v.turn){
+                g->turn = next_active_player(g, v.turn);
+                publish_view(g);
+            }
+            pthread_mutex_unlock(&g->mtx);
+            continue;
+        }
+
+        pcb_t *p = &tbl->pcbs[v.turn];
+        if(v.turn != burst_turn || v.version != burst_version){
+            burst_turn = v.turn;
+            burst_version = v.version;
+            p->burst_start_ns = now_ns();
+            p->burst_open = 1;
+            long applied = atomic_load_explicit(&g->applied_ns, memory_order_relaxed);
+            if(applied){
+                LAT_RECORD(g->metrics, LAT_DISPATCH, p->burst_start_ns - applied);
+                LAT_RECORD(g->metrics, LAT_TOTAL,
+                           p->burst_start_ns - atomic_load_explicit(&g->applied_push_ns, memory_order_relaxed));
+            }
+        }
+        coro_dispatch(tbl, v.turn, burst_version);
+
+        // Un bot que cedió vuelve a correr enseguida; solo se espera a la cola
+        // por un asiento remoto, cuya jugada la encola el servidor, o por uno
+        // que espera lugar en la cola llena.
+        int wait_ms = (tbl->pctx[v.turn].is_remote || co->queue_full) ? co->wait_ms : 0;
+        int n = moveq_pop_batch_timed(g->table_id, batch, MOVE_BATCH_MAX, wait_ms);
+        if(n) validator_apply_batch(g, batch, n);
+    }
+    moveq_close_table(g->table_id);
+    return NULL;
+}
+
+/* ===== Exportación de métricas ===== */
+typedef struct {
+    long moves_applied, passes, draws, games_finished, games_blocked, dispatches, queue_depth;
+    long pops, batches, lock_acquisitions, drops, idle_saved_us;
+} metrics_sum_t;
+
+static long slot_read(const atomic_long *v){
+    return atomic_load_explicit(v, memory_order_relaxed);
+}
+
+static void metrics_add_slot(metrics_sum_t *sum, const metrics_slot_t *s){
+    sum->moves_applied  += slot_read(&s->moves_applied);
+    sum->passes         += slot_read(&s->passes);
+    sum->draws          += slot_read(&s->draws);
+    sum->games_finished += slot_read(&s->games_finished);
+    sum->games_blocked  += slot_read(&s->games_blocked);
+    sum->dispatches     += slot_read(&s->dispatches);
+    sum->queue_depth    += slot_read(&s->pushes) - slot_read(&s->pops) - slot_read(&s->drops);
+    sum->pops           += slot_read(&s->pops);
+    sum->batches        += slot_read(&s->batches);
+    sum->lock_acquisitions += slot_read(&s->lock_acquisitions);
+    sum->drops          += slot_read(&s->drops);
+    sum->idle_saved_us  += slot_read(&s->idle_saved_us);
+}
+
+static metrics_sum_t metrics_table_sum(const table_metrics_t *tm){
+    metrics_sum_t sum = {0};
+    metrics_add_slot(&sum, &tm->validator);
+    metrics_add_slot(&sum, &tm->scheduler);
+    for(int i=0;i<MAX_PLAYERS;i++) metrics_add_slot(&sum, &tm->seat[i]);
+    if(sum.queue_depth < 0) sum.queue_depth = 0; // lectura no atómica del par
+    return sum;
+}
+
+static metrics_sum_t metrics_global_sum(void){
+    metrics_sum_t total = {0};
+    for(int t=0;t<metrics_table_count;t++){
+        metrics_add_slot(&total, &metrics_tables[t].validator);
+    }
+    return total;
+}
+
+static void print_validator_summary(void){
+    metrics_sum_t v = metrics_global_sum();
+    if(v.batches == 0) return;
+    printf("Validador: %ld jugadas en %ld lotes (lote medio %.2f), %.2f tomas de g->mtx por jugada\n",
+           v.pops, v.batches, (double)v.pops/v.batches, v.pops ? (double)v.lock_acquisitions/v.pops : 0.0);
+}
+
+// Fusiona los histogramas de todas las mesas y muestra percentiles por etapa.
+static void print_latency_report(void){
+    static const double QUANTILES[] = { 0.50, 0.90, 0.99, 0.999 };
+    printf("Latencia (us) %10s %10s %10s %10s %10s  etapa\n", "jugadas", "p50", "p90", "p99", "p99.9");
+    for(int st=0;st<LAT_STAGES;st++){
+        static unsigned long merged[LAT_BUCKETS];
+        unsigned long total = 0;
+        for(int b=0;b<LAT_BUCKETS;b++){
+            merged[b] = 0;
+            for(int f=0;f<lat_stripe_count;f++){
+                merged[b] += atomic_load_explicit(&lat_stripes[f*LAT_STAGES + st].bucket[b], memory_order_relaxed);
+            }
+            total += merged[b];
+        }
+        printf("%13s %10lu", "", total);
+        unsigned long seen = 0;
+        int b = 0;
+        for(int q=0;q<4;q++){
+            unsigned long rank = (unsigned long)(QUANTILES[q] * total);
+            if(rank >= total && total) rank = total - 1;
+            while(b < LAT_BUCKETS - 1 && seen + merged[b] <= rank){
+                seen += merged[b];
+                b++;
+            }
+            if(total) printf(" %10.1f", lat_bucket_high(b) / 1000.0);
+            else printf(" %10s", "-");
+        }
+        printf("  %s\n", LAT_STAGE_NAMES[st]);
+    }
+}
+
+static const struct { const char *name, *type, *help; size_t off; } METRIC_DEFS[] = {
+    { "moves_applied_total",  "counter", "Fichas colocadas por el validador",         offsetof(metrics_sum_t, moves_applied) },
+    { "passes_total",         "counter", "Pases aplicados",                           offsetof(metrics_sum_t, passes) },
+    { "draws_total",          "counter", "Fichas robadas del pozo",                   offsetof(metrics_sum_t, draws) },
+    { "games_finished_total", "counter", "Partidas terminadas",                       offsetof(metrics_sum_t, games_finished) },
+    { "games_blocked_total",  "counter", "Partidas terminadas por bloqueo",           offsetof(metrics_sum_t, games_blocked) },
+    { "scheduler_dispatches_total", "counter", "Despachos del planificador",          offsetof(metrics_sum_t, dispatches) },
+    { "validator_pops_total", "counter", "Jugadas extraídas de la cola por el validador", offsetof(metrics_sum_t, pops) },
+    { "validator_batches_total", "counter", "Lotes extraídos por el validador",        offsetof(metrics_sum_t, batches) },
+    { "validator_lock_acquisitions_total", "counter", "Tomas de g->mtx del validador", offsetof(metrics_sum_t, lock_acquisitions) },
+    { "validator_drops_total", "counter", "Jugadas descartadas de la cola al terminar su mesa", offsetof(metrics_sum_t, drops) },
+    { "queue_depth",          "gauge",   "Jugadas encoladas pendientes de validar",   offsetof(metrics_sum_t, queue_depth) },
+    { "scheduler_idle_saved_us", "gauge", "Espera ahorrada en porciones vencidas frente al cuantum fijo (us)", offsetof(metrics_sum_t, idle_saved_us) },
+};
+#define METRIC_DEF_COUNT ((int)(sizeof(METRIC_DEFS)/sizeof(METRIC_DEFS[0])))
+
+static long metric_value(const metrics_sum_t *sum, int i){
+    return *(const long*)((const char*)sum + METRIC_DEFS[i].off);
+}
+
+// Escribe en un temporal y renombra, así quien raspa nunca lee un archivo a medias.
+static void write_metrics_file(const char *path, int json){
+    int n = metrics_table_count;
+    metrics_sum_t *per_table = calloc(n > 0 ? n : 1, sizeof(metrics_sum_t));
+    if(!per_table) return;
+    metrics_sum_t total = {0};
+    for(int t=0;t<n;t++){
+        per_table[t] = metrics_table_sum(&metrics_tables[t]);
+        for(int i=0;i<METRIC_DEF_COUNT;i++){
+            *(long*)((char*)&total + METRIC_DEFS[i].off) += metric_value(&per_table[t], i);
+        }
+    }
+
+    char tmp[512];
+    snprintf(tmp, sizeof(tmp), "%s.tmp", path);
+    FILE *f = fopen(tmp, "w");
+    if(!f){
+        free(per_table);
+        return;
+    }
+    if(json){
+        fprintf(f, "{\"timestamp_ms\":%ld,\"tables\":%d,\"global\":{", now_ms(), n);
+        for(int i=0;i<METRIC_DEF_COUNT;i++){
+            fprintf(f, "%s\"%s\":%ld", i?",":"", METRIC_DEFS[i].name, metric_value(&total, i));
+        }
+        fprintf(f, "},\"per_table\":[");
+        for(int t=0;t<n;t++){
+            fprintf(f, "%s{\"table\":%d", t?",":"", t+1);
+            for(int i=0;i<METRIC_DEF_COUNT;i++){
+                fprintf(f, ",\"%s\":%ld", METRIC_DEFS[i].name, metric_value(&per_table[t], i));
+            }
+            fprintf(f, "}");
+        }
+        fprintf(f, "]}\n");
+    }else{
+        for(int i=0;i<METRIC_DEF_COUNT;i++){
+            fprintf(f, "# HELP domino_%s %s.\n# TYPE domino_%s %s\n", METRIC_DEFS[i].name, METRIC_DEFS[i].help,
+                    METRIC_DEFS[i].name, METRIC_DEFS[i].type);
+            fprintf(f, "domino_%s %ld\n", METRIC_DEFS[i].name, metric_value(&total, i));
+        }
+        for(int i=0;i<METRIC_DEF_COUNT;i++){
+            fprintf(f, "# HELP domino_table_%s %s, por mesa.\n# TYPE domino_table_%s %s\n", METRIC_DEFS[i].name,
+                    METRIC_DEFS[i].help, METRIC_DEFS[i].name, METRIC_DEFS[i].type);
+            for(int t=0;t<n;t++){
+                fprintf(f, "domino_table_%s{table=\"%d\"} %ld\n", METRIC_DEFS[i].name, t+1, metric_value(&per_table[t], i));
+            }
+        }
+    }
+    fclose(f);
+    rename(tmp, path);
+    free(per_table);
+}
+
+/* ===== Panel (dashboard) ===== */
+// Una fila por mesa en una región fija de la pantalla. Solo se reescriben las
+// filas cuya versión (o pozo) cambió desde el último dibujo, y un cubo de
+// bytes limita la salida a cfg.dashboard_rate por segundo: las filas que no
+// caben esperan al siguiente tick, retomando donde se cortó.
+typedef struct {
+    int rows;                 // filas de mesas visibles (el resto va al resumen)
+    uint32_t *drawn_version;  // por mesa visible
+    int *drawn_pool;
+    int cursor;               // primera fila a revisar en el próximo tick
+    long budget;              // bytes disponibles
+    long last_ns;
+    char header[DASH_ROW_LEN];
+    long bytes, redraws, deferred, started_ns;
+} dashboard_t;
+
+static int terminal_rows(void){
+    struct winsize ws;
+    if(ioctl(STDOUT_FILENO, TIOCGWINSZ, &ws) == 0 && ws.ws_row > 4) return ws.ws_row;
+    const char *env = getenv("LINES");
+    if(env && atoi(env) > 4) return atoi(env);
+    return 24;
+}
+
+static int dashboard_init(dashboard_t *d, int table_count){
+    memset(d, 0, sizeof(*d));
+    d->rows = terminal_rows() - 2; // cabecera arriba, cursor libre abajo
+    if(d->rows > table_count) d->rows = table_count;
+    d->drawn_version = malloc(sizeof(uint32_t)*(size_t)(d->rows > 0 ? d->rows : 1));
+    d->drawn_pool = malloc(sizeof(int)*(size_t)(d->rows > 0 ? d->rows : 1));
+    if(!d->drawn_version || !d->drawn_pool){
+        free(d->drawn_version);
+        free(d->drawn_pool);
+        return 0;
+    }
+    for(int i=0;i<d->rows;i++){
+        d->drawn_version[i] = UINT32_MAX;
+        d->drawn_pool[i] = -1;
+    }
+    d->budget = cfg.dashboard_rate;
+    d->last_ns = d->started_ns = now_ns();
+    pthread_mutex_lock(&io_mtx);
+    fputs("\x1b[2J", stdout); // la limpieza inicial no cuenta contra el límite
+    fflush(stdout);
+    pthread_mutex_unlock(&io_mtx);
+    return 1;
+}
+
+static int dashboard_row(table_runtime_t *tbl, table_view_t v, int pool, char *out, size_t n){
+    game_state_t *g = &tbl->state;
+    int used = snprintf(out, n, "Mesa %4d v%-5u ", g->table_id+1, v.version);
+    if(v.finished){
+        used += snprintf(out+used, n-used, "terminada: J%d %s", g->winner+1, g->blocked?"(bloqueo)":"(mano limpia)");
+    }else{
+        used += snprintf(out+used, n-used, "turno J%-2d izq %2d der %2d pozo %2d manos", v.turn+1, v.left, v.right, pool);
+        for(int i=0;i<g->player_count && used < (int)n-4;i++){
+            pthread_mutex_lock(&g->hand_mtx[i]);
+            int len = g->hand_len[i];
+            pthread_mutex_unlock(&g->hand_mtx[i]);
+            used += snprintf(out+used, n-used, " %d", len);
+        }
+    }
+    return used < (int)n ? used : (int)n-1;
+}
+
+// Escribe con io_mtx tomado; devuelve 0 si no había presupuesto.
+static int dashboard_emit(dashboard_t *d, int screen_row, const char *text, int len){
+    char buf[DASH_ROW_LEN + 32];
+    int n = snprintf(buf, sizeof(buf), "\x1b[%d;1H%.*s\x1b[K", screen_row, len, text);
+    if(n > (int)sizeof(buf)-1) n = (int)sizeof(buf)-1;
+    if(n > d->budget) return 0;
+    fwrite(buf, 1, (size_t)n, stdout);
+    d->budget -= n;
+    d->bytes += n;
+    return 1;
+}
+
+static void dashboard_tick(dashboard_t *d, reporter_ctx_t *ctx, int finished_count){
+    long now = now_ns();
+    d->budget += (long)((double)cfg.dashboard_rate * (now - d->last_ns) / 1e9);
+    if(d->budget > cfg.dashboard_rate) d->budget = cfg.dashboard_rate; // como mucho 1 s acumulado
+    d->last_ns = now;
+
+    pthread_mutex_lock(&io_mtx);
+    char header[DASH_ROW_LEN];
+    int hlen = snprintf(header, sizeof(header), "%d mesas: %d en juego, %d terminadas | mostradas %d",
+                        ctx->table_count, ctx->table_count - finished_count, finished_count, d->rows);
+    if(strcmp(header, d->header) != 0 && dashboard_emit(d, 1, header, hlen)){
+        memcpy(d->header, header, sizeof(header));
+    }
+    int deferred = 0;
+    long bytes_before = d->bytes;
+    for(int k=0;k<d->rows;k++){
+        int i = (d->cursor + k) % d->rows;
+        table_runtime_t *tbl = &ctx->tables[i];
+        table_view_t v = load_view(&tbl->state);
+        int pool = pool_count(&tbl->state);
+        if(v.version == d->drawn_version[i] && pool == d->drawn_pool[i]) continue;
+        char row[DASH_ROW_LEN];
+        int len = dashboard_row(tbl, v, pool, row, sizeof(row));
+        if(!dashboard_emit(d, i + 2, row, len)){
+            // Sin presupuesto: esta fila abre el próximo tick.
+            d->cursor = i;
+            deferred = 1;
+            d->deferred++;
+            break;
+        }
+        d->drawn_version[i] = v.version;
+        d->drawn_pool[i] = pool;
+        d->redraws++;
+    }
+    if(!deferred) d->cursor = 0;
+    if(d->bytes != bytes_before){
+        // El cursor queda bajo el panel (sin contar: son 8 bytes por tick con cambios).
+        fprintf(stdout, "\x1b[%d;1H", d->rows + 2);
+        fflush(stdout);
+    }
+    pthread_mutex_unlock(&io_mtx);
+}
+
+static void dashboard_finish(dashboard_t *d){
+    double secs = (now_ns() - d->started_ns) / 1e9;
+    pthread_mutex_lock(&io_mtx);
+    printf("\x1b[%d;1H\nPanel: %ld bytes en %.1f s (%.0f B/s, límite %d), %ld filas redibujadas, %ld ticks recortados\n",
+           d->rows + 2, d->bytes, secs, secs > 0 ? d->bytes/secs : 0.0, cfg.dashboard_rate, d->redraws, d->deferred);
+    fflush(stdout);
+    pthread_mutex_unlock(&io_mtx);
+    free(d->drawn_version);
+    free(d->drawn_pool);
+}
+
+static void *reporter_thread(void *arg){
+    reporter_ctx_t *ctx = (reporter_ctx_t*)arg;
+    dashboard_t dash;
+    int use_dash = cfg.dashboard && !ctx->quiet && dashboard_init(&dash, ctx->table_count);
+    long next_ckpt = now_ms() + cfg.checkpoint_every_s*1000L;
+    while(1){
+        int all_finished = 1;
+        int finished_count = 0;
+        for(int i=0;i<ctx->table_count;i++){
+            game_state_t *g = &ctx->tables[i].state;
+            int finished = load_view(g).finished;
+            if(!finished) all_finished = 0;
+            finished_count += finished;
+            if(!ctx->quiet && !use_dash) print_table_state(&ctx->tables[i], 0);
+        }
+        if(use_dash) dashboard_tick(&dash, ctx, finished_count);
+        if(cfg.metrics_path) write_metrics_file(cfg.metrics_path, cfg.metrics_json);
+        if(atomic_exchange(&latency_dump_requested, 0)){
+            pthread_mutex_lock(&io_mtx);
+            print_latency_report();
+            fflush(stdout);
+            pthread_mutex_unlock(&io_mtx);
+        }
+        int periodic = cfg.checkpoint_every_s > 0 && now_ms() >= next_ckpt;
+        if(atomic_exchange(&checkpoint_requested, 0) || periodic){
+            if(cfg.checkpoint_path){
+                long t0 = now_ns();
+                long bytes = write_checkpoint(cfg.checkpoint_path, ctx->tables, ctx->table_count);
+                double ms = (now_ns() - t0) / 1e6;
+                if(bytes < 0) io_printf("Checkpoint en %s falló: %s\n", cfg.checkpoint_path, strerror(errno));
+                else io_printf("Checkpoint: %d mesas, %ld KB en %.1f ms -> %s\n", ctx->table_count, bytes/1024, ms, cfg.checkpoint_path);
+            }
+            next_ckpt = now_ms() + cfg.checkpoint_every_s*1000L;
+        }
+        if(all_finished) break;
+        msleep(ctx->interval_ms);
+    }
+    if(use_dash) dashboard_finish(&dash);
+    return NULL;
+}
+
+/* ===== Utilidades ===== */
+// xorshift64* con semilla mezclada por splitmix64: reproducible por partida e
+// independiente entre hilos, a diferencia de rand().
+static uint64_t rng_seed(uint64_t seed){
+    uint64_t z = seed + 0x9e3779b97f4a7c15ULL;
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+    z ^= z >> 31;
+    return z ? z : 1;
+}
+static uint64_t rng_next(uint64_t *state){
+    uint64_t x = *state;
+    x ^= x >> 12; x ^= x << 25; x ^= x >> 27;
+    *state = x;
+    return x * 0x2545f4914f6cdd1dULL;
+}
+
+// Con rng == NULL baraja con rand().
+static void shuffle(tile_t *v, int n, uint64_t *rng){
+    for(int i=n-1;i>0;i--){
+        int j = rng ? (int)(rng_next(rng) % (uint64_t)(i+1)) : rand() % (i+1);
+        tile_t tmp = v[i]; v[i]=v[j]; v[j]=tmp;
+    }
+}
+
+static void build_shuffled_deck(const domino_set_t *set, tile_t *deck, int *out_len, uint64_t *rng){
+    int idx = 0;
+    for(int a = 0; a <= set->max_pip; ++a){
+        for(int b = a; b <= set->max_pip; ++b){
+            deck[idx++] = (tile_t){ .a = a, .b = b };
+        }
+    }
+    *out_len = idx;
+    shuffle(deck, idx, rng);
+}
+
+static const domino_set_t *find_domino_set(int max_pip){
+    for(int i=0;i<DOMINO_SET_COUNT;i++){
+        if(DOMINO_SETS[i].max_pip == max_pip) return &DOMINO_SETS[i];
+    }
+    return NULL;
+}
+
+static int set_deal(const domino_set_t *set, int player_count){
+    if(player_count < 2 || player_count > set->max_players) return 0;
+    return set->deal[player_count];
+}
+
+// Reparte el bloque de fichas del estado: manos (cada una puede absorber el
+// pozo completo), pozo y tren. Doble-seis cabe siempre en small_store.
+static int layout_game_storage(game_state_t *g, int player_count, int deal){
+    int tiles = g->set->tiles;
+    int pool_cap = tiles - deal*player_count;
+    g->hand_cap = deal + pool_cap;
+    int needed = player_count*g->hand_cap + pool_cap + tiles;
+
+    tile_t *store = g->small_store;
+    if(needed > D6_STORAGE){
+        if(g->heap_cap < needed){
+            tile_t *grown = realloc(g->heap_store, sizeof(tile_t)*needed);
+            if(!grown) return 0;
+            g->heap_store = grown;
+            g->heap_cap = needed;
+        }
+        store = g->heap_store;
+    }
+    g->store_len = needed;
+
+    for(int pid = 0; pid < MAX_PLAYERS; ++pid){
+        g->hands[pid] = NULL;
+    }
+    for(int pid = 0; pid < player_count; ++pid){
+        g->hands[pid] = store;
+        store += g->hand_cap;
+    }
+    g->pool = store; store += pool_cap;
+    g->train = store;
+    return 1;
+}
+
+static int setup_game_state(game_state_t *g, const domino_set_t *set, int table_id, int player_count, int human_player, uint64_t *rng){
+    int deal = set_deal(set, player_count);
+    if(deal <= 0) return 0;
+
+    g->set = set;
+    if(!layout_game_storage(g, player_count, deal)) return 0;
+
+    tile_t deck[MAX_TILES];
+    int deck_len = 0;
+    build_shuffled_deck(set, deck, &deck_len, rng);
+
+    g->table_id = table_id;
+    g->player_count = player_count;
+    g->human_player = human_player;
+    g->finished = 0;
+    g->train_len = 0;
+    g->left_end = -1;
+    g->right_end = -1;
+    g->turn = 0;
+    g->winner = -1;
+    g->blocked = 0;
+    g->passes_in_row = 0;
+    g->history_count = 0;
+    g->version = 0;
+    atomic_store(&g->applied_push_ns, 0);
+    atomic_store(&g->applied_ns, 0);
+
+    for(int pid = 0; pid < MAX_PLAYERS; ++pid){
+        g->hand_len[pid] = 0;
+    }
+
+    int deck_pos = 0;
+    for(int pid = 0; pid < player_count; ++pid){
+        for(int j = 0; j < deal && deck_pos < deck_len; ++j){
+            g->hands[pid][j] = deck[deck_pos++];
+        }
+        g->hand_len[pid] = deal;
+    }
+
+    int pool_len = 0;
+    while(deck_pos < deck_len){
+        g->pool[pool_len++] = deck[deck_pos++];
+    }
+    atomic_store_explicit(&g->pool_top, pool_len, memory_order_release);
+
+    int start_pid = -1;
+    int start_idx = -1;
+    tile_t start_tile = {0, 0};
+    int best_double = -1;
+    for(int pid = 0; pid < player_count; ++pid){
+        for(int j = 0; j < g->hand_len[pid]; ++j){
+            tile_t t = g->hands[pid][j];
             if(t.a == t.b && t.a > best_double){
                 best_double = t.a;
                 start_pid = pid;
@@ -851,36 +3812,88 @@ static void setup_game_state(game_state_t *g, int table_id, int player_count, in
         g->right_end = start_tile.b;
         g->turn = (start_pid + 1) % player_count;
     }
+    publish_view(g);
+    return 1;
+}
+
+static void release_game_state(game_state_t *g){
+    free(g->heap_store);
+    g->heap_store = NULL;
+    g->heap_cap = 0;
+}
+static void init_game_locks(game_state_t *g){
+    pthread_mutex_init(&g->mtx, NULL);
+    for(int i=0;i<MAX_PLAYERS;i++) pthread_mutex_init(&g->hand_mtx[i], NULL);
+}
+static void destroy_game_locks(game_state_t *g){
+    for(int i=0;i<MAX_PLAYERS;i++) pthread_mutex_destroy(&g->hand_mtx[i]);
+    pthread_mutex_destroy(&g->mtx);
+}
+// Escritor único: quien tenga g->mtx (o setup antes de arrancar los hilos).
+static void publish_view(game_state_t *g){
+    uint64_t v = (uint64_t)(uint8_t)(g->left_end + 1)
+               | (uint64_t)(uint8_t)(g->right_end + 1) << 8
+               | (uint64_t)(uint8_t)(g->turn + 1) << 16
+               | (uint64_t)(g->finished ? 1 : 0) << 24
+               | (uint64_t)(uint32_t)g->version << 32;
+    atomic_store_explicit(&g->view, v, memory_order_release);
 }
-static int can_play(const game_state_t *g, int pid, tile_t *out, int *side){
+static table_view_t load_view(game_state_t *g){
+    uint64_t v = atomic_load_explicit(&g->view, memory_order_acquire);
+    table_view_t tv;
+    tv.left = (int)(v & 0xff) - 1;
+    tv.right = (int)((v >> 8) & 0xff) - 1;
+    tv.turn = (int)((v >> 16) & 0xff) - 1;
+    tv.finished = (int)((v >> 24) & 1);
+    tv.version = (uint32_t)(v >> 32);
+    return tv;
+}
+static int pool_count(game_state_t *g){
+    int n = atomic_load_explicit(&g->pool_top, memory_order_acquire);
+    return n > 0 ? n : 0;
+}
+static int can_play(game_state_t *g, int pid, tile_t *out, int *side){
     if(pid < 0 || pid >= g->player_count) return 0;
-    if(g->turn != pid) return 0;
-    if(g->hand_len[pid] <= 0) return 0;
-    int left = g->left_end;
-    int right = g->right_end;
-    for(int i=0;i<g->hand_len[pid];++i){
+    table_view_t v = load_view(g);
+    if(v.turn != pid) return 0;
+    int left = v.left;
+    int right = v.right;
+    int found = 0;
+    pthread_mutex_lock(&g->hand_mtx[pid]);
+    for(int i=0;i<g->hand_len[pid] && !found;++i){
         tile_t t = g->hands[pid][i];
         if(left == -1 || t.a == left || t.b == left){
             if(out) *out = t;
             if(side) *side = -1;
-            return 1;
-        }
-        if(right == -1 || t.a == right || t.b == right){
+            found = 1;
+        }else if(right == -1 || t.a == right || t.b == right){
             if(out) *out = t;
             if(side) *side = 1;
-            return 1;
+            found = 1;
         }
     }
-    return 0;
+    pthread_mutex_unlock(&g->hand_mtx[pid]);
+    return found;
 }
+// Robo sin lock global: reclamar el índice del tope es un único fetch_sub.
+// Si otro robo vació el pozo antes, el tope queda negativo y no se roba nada.
 static int draw_from_pool(game_state_t *g, int pid){
     if(pid < 0 || pid >= g->player_count) return 0;
-    if(g->pool_len <= 0) return 0;
-    if(g->hand_len[pid] >= 14) return 0;
-    tile_t t = g->pool[g->pool_len-1];
-    g->pool_len--;
-    g->hands[pid][g->hand_len[pid]] = t;
+    if(pool_count(g) == 0) return 0;
+    pthread_mutex_lock(&g->hand_mtx[pid]);
+    if(g->hand_len[pid] >= g->hand_cap){
+        pthread_mutex_unlock(&g->hand_mtx[pid]);
+        return 0;
+    }
+    int top = atomic_fetch_sub_explicit(&g->pool_top, 1, memory_order_acq_rel);
+    if(top <= 0){
+        pthread_mutex_unlock(&g->hand_mtx[pid]);
+        return 0;
+    }
+    g->hands[pid][g->hand_len[pid]] = g->pool[top-1];
     g->hand_len[pid] += 1;
+    pthread_mutex_unlock(&g->hand_mtx[pid]);
+    METRIC_INC(g->metrics, seat[pid], draws);
     return 1;
 }
 static long now_ms(void){
@@ -889,169 +3902,1196 @@ static long now_ms(void){
 }
 static void msleep(int ms){ usleep(ms*1000); }
 
-/* ===== main ===== */
-int main(int argc, char **argv){
-    (void)argc; (void)argv;
+/* ===== Configuración ===== */
+static void print_usage(const char *prog){
+    fprintf(stderr,
+        "Uso: %s [opciones]\n"
+        "  --set N          juego doble-N (por defecto 6)\n"
+        "  --players N      jugadores por mesa (2..máximo del juego; por defecto aleatorio 2-4)\n"
+        "  --bench-sets P   juega P partidas sin hilos por juego y reporta ns/jugada\n"
+        "  --turn-timeout S segundos por turno humano antes de jugar por él (0 = sin límite, por defecto 60)\n"
+        "  --timeout-action play|pass  al vencer el turno humano juega la estrategia del asiento o solo lo mínimo: pasa si\n"
+        "                   no tiene jugada ni fichas que robar, si no la primera que encaje (por defecto play)\n"
+        "  --serve ADDR     servidor de sockets en unix:/ruta o tcp:PUERTO (loopback), sin preguntas\n"
+        "  --tables N       mesas en modo servidor (por defecto 1)\n"
+        "  --remote-seats K asientos por mesa para clientes remotos (por defecto todos)\n"
+        "  --client ADDR    generador de carga contra un servidor --serve\n"
+        "  --conns N        conexiones del generador de carga (por defecto 1)\n"
+        "  --duration S     duración máxima de la carga en segundos (por defecto 60)\n"
+        "  --metrics RUTA   exporta contadores cada 500 ms (JSON si termina en .json, si no Prometheus)\n"
+        "  --metrics-format prom|json  fuerza el formato del archivo de métricas\n"
+        "  --quantum MS     cuantum Round-Robin inicial en ms (por defecto 50)\n"
+        "  --quantum-bounds MIN:MAX  límites del cuantum adaptativo por jugador en ms (por defecto 1:1000)\n"
+        "  --affinity none|core|group:N|node  fija los hilos de cada mesa a un núcleo, grupo o nodo (round-robin)\n"
+        "  --bench-affinity compara jugadas/s y cambios de contexto de --tables mesas de bots sin fijar y fijadas\n"
+        "  --bench-footprint mide bytes por mesa (sin hilos) con 1000 y 100000 mesas\n"
+        "  --checkpoint RUTA guarda todas las mesas en RUTA con SIGUSR2 o el comando ckpt\n"
+        "  --checkpoint-every S  además guarda cada S segundos\n"
+        "  --resume RUTA    reanuda las mesas de un checkpoint sin repartir ni preguntar\n"
+        "  --bench-checkpoint RUTA  mide guardar y restaurar --tables mesas a medio jugar\n"
+        "  --analyze N      juega N partidas de bots sin hilos y agrupa victorias por rasgos de la mano inicial\n"
+        "  --analyze-out RUTA  CSV del análisis (por defecto manos.csv)\n"
+        "  --analyze-threads N  hilos del análisis (por defecto uno por CPU)\n"
+        "  --seed S         semilla del análisis y del torneo (por defecto según la hora)\n"
+        "  --bots E1,E2,... estrategia de cada asiento bot, cíclica: primera|pesada|diversidad|azar|memoria (por defecto primera)\n"
+        "  --bench-bots N   torneo de N partidas sin hilos entre las estrategias de --bots (por defecto todas)\n"
+        "  --dashboard      panel ANSI en sitio: una fila por mesa, solo se redibuja lo que cambió\n"
+        "  --dashboard-rate B  bytes/s máximos del panel (por defecto 8192)\n"
+        "  --queue-cap N    jugadas pendientes máximas en la cola de movimientos (por defecto 256)\n"
+        "  --queue-full block|fail  con la cola llena, esperar o rechazar la jugada (por defecto block)\n"
+        "  --exec threads|coro  un hilo por asiento más validador y planificador, o un solo hilo por mesa con corrutinas (por defecto threads)\n"
+        "  --bench-coro     compara jugadas/s y despachos/s de --tables mesas de bots con hilos y con corrutinas\n"
+        "  --sched threads|wheel  un hilo planificador por mesa o una rueda de temporizadores compartida (por defecto threads)\n"
+        "  --bench-wheel N  compara despertares/s y retraso de los cuantums con un hilo planificador por mesa y con la\n"
+        "                   rueda: --tables mesas de bots y N planificadores sintéticos (solo el modelo de --sched si se indica)\n",
+        prog);
+}
 
-    srand((unsigned)time(NULL));
+static int parse_args(int argc, char **argv){
+    int metrics_format = -1;
+    for(int i=1;i<argc;i++){
+        const char *arg = argv[i];
+        const char *val = (i+1 < argc) ? argv[i+1] : NULL;
+        if(strcmp(arg, "--set") == 0 && val){
+            cfg.set = find_domino_set(atoi(val));
+            if(!cfg.set){
+                fprintf(stderr, "Juego no soportado: doble-%s.\n", val);
+                return 0;
+            }
+            i++;
+        }else if(strcmp(arg, "--players") == 0 && val){
+            cfg.players = atoi(val);
+            i++;
+        }else if(strcmp(arg, "--bench-sets") == 0 && val){
+            cfg.bench_games = atoi(val);
+            i++;
+        }else if(strcmp(arg, "--turn-timeout") == 0 && val){
+            cfg.turn_timeout_ms = atoi(val) * 1000;
+            i++;
+        }else if(strcmp(arg, "--serve") == 0 && val){
+            cfg.serve_addr = val;
+            i++;
+        }else if(strcmp(arg, "--tables") == 0 && val){
+            cfg.tables = atoi(val);
+            i++;
+        }else if(strcmp(arg, "--remote-seats") == 0 && val){
+            cfg.remote_seats = atoi(val);
+            i++;
+        }else if(strcmp(arg, "--client") == 0 && val){
+            cfg.client_addr = val;
+            i++;
+        }else if(strcmp(arg, "--conns") == 0 && val){
+            cfg.conns = atoi(val);
+            i++;
+        }else if(strcmp(arg, "--duration") == 0 && val){
+            cfg.duration_s = atoi(val);
+            i++;
+        }else if(strcmp(arg, "--metrics") == 0 && val){
+            cfg.metrics_path = val;
+            i++;
+        }else if(strcmp(arg, "--metrics-format") == 0 && val){
+            if(strcmp(val, "json") == 0) metrics_format = 1;
+            else if(strcmp(val, "prom") == 0) metrics_format = 0;
+            else return 0;
+            i++;
+        }else if(strcmp(arg, "--quantum") == 0 && val){
+            cfg.quantum_ms = atoi(val);
+            i++;
+        }else if(strcmp(arg, "--quantum-bounds") == 0 && val){
+            if(sscanf(val, "%d:%d", &cfg.quantum_min_ms, &cfg.quantum_max_ms) != 2) return 0;
+            i++;
+        }else if(strcmp(arg, "--affinity") == 0 && val){
+            if(strcmp(val, "none") == 0) cfg.pin_mode = PIN_NONE;
+            else if(strcmp(val, "core") == 0) cfg.pin_mode = PIN_CORE;
+            else if(strcmp(val, "node") == 0) cfg.pin_mode = PIN_NODE;
+            else if(strncmp(val, "group:", 6) == 0 && atoi(val+6) > 0){
+                cfg.pin_mode = PIN_GROUP;
+                cfg.pin_group = atoi(val+6);
+            }else return 0;
+            i++;
+        }else if(strcmp(arg, "--dashboard") == 0){
+            cfg.dashboard = 1;
+        }else if(strcmp(arg, "--dashboard-rate") == 0 && val){
+            cfg.dashboard_rate = atoi(val);
+            i++;
+        }else if(strcmp(arg, "--queue-cap") == 0 && val){
+            cfg.queue_cap = atoi(val);
+            i++;
+        }else if(strcmp(arg, "--queue-full") == 0 && val){
+            if(strcmp(val, "block") == 0) cfg.queue_full = QFULL_BLOCK;
+            else if(strcmp(val, "fail") == 0) cfg.queue_full = QFULL_FAIL;
+            else return 0;
+            i++;
+        }else if(strcmp(arg, "--exec") == 0 && val){
+            if(strcmp(val, "threads") == 0) cfg.exec_mode = EXEC_THREADS;
+            else if(strcmp(val, "coro") == 0) cfg.exec_mode = EXEC_CORO;
+            else return 0;
+            i++;
+        }else if(strcmp(arg, "--sched") == 0 && val){
+            if(strcmp(val, "threads") == 0) cfg.sched_wheel = 0;
+            else if(strcmp(val, "wheel") == 0) cfg.sched_wheel = 1;
+            else return 0;
+            cfg.sched_given = 1;
+            i++;
+        }else if(strcmp(arg, "--bench-wheel") == 0 && val){
+            cfg.bench_wheel = atoi(val);
+            i++;
+        }else if(strcmp(arg, "--bench-coro") == 0){
+            cfg.bench_coro = 1;
+        }else if(strcmp(arg, "--bench-affinity") == 0){
+            cfg.bench_affinity = 1;
+        }else if(strcmp(arg, "--bench-footprint") == 0){
+            cfg.bench_footprint = 1;
+        }else if(strcmp(arg, "--checkpoint") == 0 && val){
+            cfg.checkpoint_path = val;
+            i++;
+        }else if(strcmp(arg, "--checkpoint-every") == 0 && val){
+            cfg.checkpoint_every_s = atoi(val);
+            i++;
+        }else if(strcmp(arg, "--resume") == 0 && val){
+            cfg.resume_path = val;
+            i++;
+        }else if(strcmp(arg, "--bench-checkpoint") == 0 && val){
+            cfg.bench_checkpoint = val;
+            i++;
+        }else if(strcmp(arg, "--analyze") == 0 && val){
+            cfg.analyze_games = atol(val);
+            i++;
+        }else if(strcmp(arg, "--analyze-out") == 0 && val){
+            cfg.analyze_out = val;
+            i++;
+        }else if(strcmp(arg, "--analyze-threads") == 0 && val){
+            cfg.analyze_threads = atoi(val);
+            i++;
+        }else if(strcmp(arg, "--seed") == 0 && val){
+            cfg.seed = atol(val);
+            i++;
+        }else if(strcmp(arg, "--bots") == 0 && val){
+            cfg.bot_count = 0;
+            for(const char *p = val; *p; ){
+                size_t len = strcspn(p, ",");
+                const bot_strategy_t *st = find_bot_strategy(p, len);
+                if(!st || cfg.bot_count == MAX_PLAYERS){
+                    fprintf(stderr, "Estrategia desconocida o demasiadas en --bots: %.*s (primera, pesada, diversidad, azar, memoria).\n", (int)len, p);
+                    return 0;
+                }
+                cfg.bots[cfg.bot_count++] = st;
+                p += len;
+                if(*p == ',') p++;
+            }
+            if(cfg.bot_count == 0) return 0;
+            i++;
+        }else if(strcmp(arg, "--bench-bots") == 0 && val){
+            cfg.bench_bots = atol(val);
+            i++;
+        }else if(strcmp(arg, "--timeout-action") == 0 && val){
+            if(strcmp(val, "play") == 0) cfg.timeout_action = TIMEOUT_PLAY;
+            else if(strcmp(val, "pass") == 0) cfg.timeout_action = TIMEOUT_PASS;
+            else return 0;
+            i++;
+        }else{
+            return 0;
+        }
+    }
+    if(cfg.metrics_path){
+        size_t len = strlen(cfg.metrics_path);
+        cfg.metrics_json = (metrics_format >= 0) ? metrics_format
+                         : (len > 5 && strcmp(cfg.metrics_path + len - 5, ".json") == 0);
+    }
+    if(cfg.quantum_ms < 1 || cfg.queue_cap < 1 || cfg.dashboard_rate < 64) return 0;
+    if(cfg.quantum_min_ms < 1 || cfg.quantum_max_ms < cfg.quantum_min_ms) return 0;
+    if(cfg.analyze_games < 0 || cfg.analyze_threads < 0 || cfg.bench_bots < 0 || cfg.bench_wheel < 0) return 0;
+    if(cfg.checkpoint_every_s < 0 || (cfg.checkpoint_every_s > 0 && !cfg.checkpoint_path)) return 0;
+    if(cfg.serve_addr && cfg.resume_path){
+        // Un checkpoint no guarda conexiones: los asientos remotos no tienen a quién volver.
+        fprintf(stderr, "--resume no se puede combinar con --serve.\n");
+        return 0;
+    }
+    if(cfg.tables < 1 || cfg.conns < 1 || cfg.duration_s < 1 || cfg.remote_seats < 0){
+        return 0;
+    }
+    if(cfg.players != 0 && (cfg.players < 2 || cfg.players > cfg.set->max_players)){
+        fprintf(stderr, "El %s admite entre 2 y %d jugadores.\n", cfg.set->name, cfg.set->max_players);
+        return 0;
+    }
+    return 1;
+}
 
-    int keep_playing = 1;
-    while(keep_playing){
-        int tables_count = 0;
-        while(tables_count < 1){
-            printf("Ingrese la cantidad de mesas a crear (>=1): ");
-            fflush(stdout);
-            if(scanf("%d", &tables_count) != 1){
-                int ch;
-                while((ch = getchar()) != '\n' && ch != EOF){}
-                tables_count = 0;
-                printf("Entrada inválida. Intente nuevamente.\n");
-            }else if(tables_count < 1){
-                printf("La cantidad debe ser al menos 1.\n");
+/* ===== Benchmarks ===== */
+static long now_ns(void){
+    struct timespec ts; clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec*1000000000L + ts.tv_nsec;
+}
+
+// Estrategias de una partida sin hilos, con el tiempo que tardó cada asiento
+// en decidir. rng sigue la secuencia con la que se repartió.
+typedef struct {
+    const bot_strategy_t *seats[MAX_PLAYERS];
+    uint64_t rng;
+    long decisions[MAX_PLAYERS], decide_ns[MAX_PLAYERS];
+} headless_bots_t;
+
+// Juega sin hilos hasta el fin de la partida o max_moves, con la lógica de bot
+// de player_thread: bots == NULL usa can_play (la estrategia "primera") sin
+// medir. Devuelve la cantidad de jugadas (incluye robos y pases).
+static long play_headless(game_state_t *g, long max_moves, headless_bots_t *bots){
+    long moves = 0;
+    while(!g->finished && moves < max_moves){
+        int pid = g->turn;
+        tile_t t; int side = 0;
+        int ok;
+        if(bots){
+            long t0 = now_ns();
+            ok = bot_choose(g, pid, bots->seats[pid], &bots->rng, &t, &side);
+            bots->decide_ns[pid] += now_ns() - t0;
+            bots->decisions[pid]++;
+        }else{
+            ok = can_play(g, pid, &t, &side);
+        }
+        if(ok){
+            move_t mv = { .player_id=pid, .table_id=g->table_id, .t=t, .side=side };
+            apply_move(g, &mv);
+        }else if(!draw_from_pool(g, pid)){
+            move_t pass = { .player_id=pid, .table_id=g->table_id, .t={.a=-1,.b=-1}, .side=0 };
+            apply_move(g, &pass);
+        }
+        moves++;
+    }
+    return moves;
+}
+
+static long play_headless_game(game_state_t *g){
+    return play_headless(g, LONG_MAX, NULL);
+}
+
+static int run_set_benchmark(int games){
+    static game_state_t g;
+    init_game_locks(&g);
+    printf("%-12s %4s %10s %12s %10s %10s\n", "juego", "jug", "partidas", "jugadas", "ns/jugada", "bytes");
+    for(int s=0;s<DOMINO_SET_COUNT;s++){
+        const domino_set_t *set = &DOMINO_SETS[s];
+        int counts[3] = { 2, 4, set->max_players };
+        for(int c=0;c<3;c++){
+            if(c > 0 && counts[c] == counts[c-1]) continue;
+            int players = counts[c];
+            long moves = 0, elapsed = 0;
+            for(int i=0;i<games;i++){
+                if(!setup_game_state(&g, set, 0, players, -1, NULL)){
+                    fprintf(stderr, "Error al preparar %s con %d jugadores.\n", set->name, players);
+                    release_game_state(&g);
+                    destroy_game_locks(&g);
+                    return 1;
+                }
+                long t0 = now_ns();
+                moves += play_headless_game(&g);
+                elapsed += now_ns() - t0;
             }
+            size_t bytes = sizeof(game_state_t);
+            if(g.store_len > D6_STORAGE) bytes += sizeof(tile_t)*(size_t)g.store_len;
+            printf("%-12s %4d %10d %12ld %10.1f %10zu\n", set->name, players, games, moves,
+                   moves ? (double)elapsed/moves : 0.0, bytes);
+        }
+    }
+    release_game_state(&g);
+    destroy_game_locks(&g);
+    return 0;
+}
+
+// Mesas solo de bots con el modelo de ejecución de --exec, hasta que todas
+// terminan. Devuelve jugadas aplicadas (colocaciones + pases), despachos del
+// planificador (si dispatches != NULL) y la duración en ms.
+static int run_bot_tables(int tables_count, long *moves, long *dispatches, long *elapsed_ms){
+    table_runtime_t *tables = calloc(tables_count, sizeof(table_runtime_t));
+    if(!tables || !metrics_init(tables_count) || !moveq_init(cfg.queue_cap, tables_count)){
+        free(tables);
+        return 0;
+    }
+    long t0 = now_ms();
+    for(int t=0;t<tables_count;t++){
+        tables[t].seats = cfg.players ? cfg.players : rand()%3 + 2;
+        if(!start_table(&tables[t], t, -1, 0)) return 0;
+    }
+    for(int t=0;t<tables_count;t++){
+        join_table(&tables[t]);
+    }
+    *elapsed_ms = now_ms() - t0;
+    *moves = 0;
+    if(dispatches) *dispatches = 0;
+    for(int t=0;t<tables_count;t++){
+        metrics_sum_t sum = metrics_table_sum(&metrics_tables[t]);
+        *moves += sum.moves_applied + sum.passes;
+        if(dispatches) *dispatches += sum.dispatches;
+        destroy_table(&tables[t]);
+    }
+    free(tables);
+    metrics_free();
+    moveq_free();
+    return 1;
+}
+
+static int run_affinity_benchmark(void){
+    pin_mode_t modes[2] = { PIN_NONE, (cfg.pin_mode != PIN_NONE) ? cfg.pin_mode : PIN_CORE };
+    char pinned_name[32];
+    switch(modes[1]){
+        case PIN_GROUP: snprintf(pinned_name, sizeof(pinned_name), "group:%d", cfg.pin_group); break;
+        case PIN_NODE:  snprintf(pinned_name, sizeof(pinned_name), "node"); break;
+        default:        snprintf(pinned_name, sizeof(pinned_name), "core"); break;
+    }
+    const char *names[2] = { "sin fijar", pinned_name };
+    printf("%d mesas, cuantum %d ms\n", cfg.tables, cfg.quantum_ms);
+    printf("%-10s %7s %10s %10s %12s %12s %12s\n", "modo", "cubetas", "jugadas", "jugadas/s", "ctx vol", "ctx invol", "ctx/jugada");
+    for(int m=0;m<2;m++){
+        if(!placement_init(modes[m], cfg.pin_group)){
+            fprintf(stderr, "No se pudo calcular la ubicación de hilos.\n");
+            return 1;
         }
+        struct rusage r0, r1;
+        getrusage(RUSAGE_SELF, &r0);
+        long moves = 0, elapsed = 0;
+        if(!run_bot_tables(cfg.tables, &moves, NULL, &elapsed)){
+            fprintf(stderr, "Error al preparar las mesas.\n");
+            return 1;
+        }
+        getrusage(RUSAGE_SELF, &r1);
+        long vol = r1.ru_nvcsw - r0.ru_nvcsw;
+        long invol = r1.ru_nivcsw - r0.ru_nivcsw;
+        printf("%-10s %7d %10ld %10.0f %12ld %12ld %12.2f\n", names[m], placement_count, moves,
+               elapsed ? moves*1000.0/elapsed : 0.0, vol, invol, moves ? (double)(vol+invol)/moves : 0.0);
+        placement_free();
+    }
+    return 0;
+}
 
-        table_runtime_t *tables = calloc(tables_count, sizeof(table_runtime_t));
-        if(!tables){
-            fprintf(stderr, "Error al reservar memoria para las mesas.\n");
+// Las mismas mesas de bots con un hilo por asiento y con corrutinas: en ambos
+// modos un despacho es pasarle el turno a un asiento (despertar su hilo o
+// swapcontext), así que despachos/s mide el coste del traspaso.
+static int run_exec_benchmark(void){
+    const char *names[2] = { "threads", "coro" };
+    printf("%d mesas, cuantum %d ms\n", cfg.tables, cfg.quantum_ms);
+    printf("%-8s %11s %10s %10s %11s %11s %12s %12s\n", "modo", "hilos/mesa", "jugadas", "jugadas/s",
+           "despachos", "despachos/s", "ctx vol", "ctx invol");
+    for(int m=0;m<2;m++){
+        cfg.exec_mode = (m == 0) ? EXEC_THREADS : EXEC_CORO;
+        struct rusage r0, r1;
+        getrusage(RUSAGE_SELF, &r0);
+        long moves = 0, dispatches = 0, elapsed = 0;
+        if(!run_bot_tables(cfg.tables, &moves, &dispatches, &elapsed)){
+            fprintf(stderr, "Error al preparar las mesas.\n");
             return 1;
         }
+        getrusage(RUSAGE_SELF, &r1);
+        printf("%-8s %11s %10ld %10.0f %11ld %11.0f %12ld %12ld\n", names[m], m ? "1" : "asientos+2",
+               moves, elapsed ? moves*1000.0/elapsed : 0.0, dispatches, elapsed ? dispatches*1000.0/elapsed : 0.0,
+               r1.ru_nvcsw - r0.ru_nvcsw, r1.ru_nivcsw - r0.ru_nivcsw);
+    }
+    return 0;
+}
 
-        moveq_init();
+#define WHEEL_BENCH_MS 3000
 
-        for(int t=0; t<tables_count; ++t){
-            table_runtime_t *tbl = &tables[t];
-            tbl->seats = rand()%3 + 2;
+// Temporizador sintético del banco: un planificador cuyo jugador nunca cede,
+// así que solo vence su cuantum, una y otra vez.
+typedef struct { wheel_timer_t timer; int period_ms, phase_ms; } bench_timer_t;
+static atomic_int bench_timers_stop;
 
-            printf("Mesa %d: %d asientos disponibles.\n", t+1, tbl->seats);
-            bool occupy = false;
-            char opt;
-            printf("¿Desea ocupar uno de estos asientos? (s/n): ");
-            fflush(stdout);
-            if(scanf(" %c", &opt) == 1){
-                if(opt == 's' || opt == 'S'){
-                    occupy = true;
-                }
-            }else{
-                int ch;
-                while((ch = getchar()) != '\n' && ch != EOF){}
+static int bench_timer_fire(void *arg, long late_ns){
+    bench_timer_t *bt = (bench_timer_t*)arg;
+    if(late_ns >= 0) sched_timer_record(late_ns);
+    return atomic_load(&bench_timers_stop) ? -1 : bt->period_ms;
+}
+
+static void *bench_sleeper_thread(void *arg){
+    bench_timer_t *bt = (bench_timer_t*)arg;
+    int ms = bt->phase_ms;
+    while(!atomic_load(&bench_timers_stop)){
+        long due = now_ns() + (long)ms * 1000000L;
+        msleep(ms);
+        atomic_fetch_add_explicit(&sched_wakeups, 1, memory_order_relaxed);
+        sched_timer_record(now_ns() - due);
+        ms = bt->period_ms;
+    }
+    return NULL;
+}
+
+// Vencimientos registrados y su retraso p50/p99/máximo en us; reinicia el histograma.
+static unsigned long take_timer_stats(double *p50_us, double *p99_us, double *max_us){
+    static const double QUANTILES[] = { 0.50, 0.99 };
+    double *out[] = { p50_us, p99_us };
+    unsigned long merged[LAT_BUCKETS], total = 0;
+    int top = 0;
+    for(int b=0;b<LAT_BUCKETS;b++){
+        merged[b] = atomic_exchange_explicit(&sched_timer_lat.bucket[b], 0, memory_order_relaxed);
+        total += merged[b];
+        if(merged[b]) top = b;
+    }
+    unsigned long seen = 0;
+    int b = 0;
+    for(int q=0;q<2;q++){
+        unsigned long rank = (unsigned long)(QUANTILES[q] * total);
+        if(rank >= total && total) rank = total - 1;
+        while(b < LAT_BUCKETS - 1 && seen + merged[b] <= rank){
+            seen += merged[b];
+            b++;
+        }
+        *out[q] = total ? lat_bucket_high(b) / 1000.0 : 0.0;
+    }
+    *max_us = total ? lat_bucket_high(top) / 1000.0 : 0.0;
+    return total;
+}
+
+static long rusage_cpu_ms(const struct rusage *r){
+    return (r->ru_utime.tv_sec + r->ru_stime.tv_sec) * 1000L + (r->ru_utime.tv_usec + r->ru_stime.tv_usec) / 1000;
+}
+
+// Planificador con un hilo por mesa frente a la rueda compartida: primero
+// --tables mesas de bots reales, después n planificadores sintéticos que solo
+// vencen su cuantum (--quantum) durante WHEEL_BENCH_MS. Con --sched se mide
+// solo ese modelo.
+static int run_wheel_benchmark(int n){
+    const char *names[2] = { "threads", "wheel" };
+    double p50, p99, max;
+    printf("%d mesas de bots, cuantum %d ms\n", cfg.tables, cfg.quantum_ms);
+    printf("%-8s %10s %10s %12s %9s %9s %9s %9s %10s\n", "planif", "jugadas", "jugadas/s", "despertar/s",
+           "p50 us", "p99 us", "máx us", "CPU ms", "ctx vol");
+    int first = cfg.sched_given ? cfg.sched_wheel : 0, last = cfg.sched_given ? cfg.sched_wheel : 1;
+    for(int m=first;m<=last;m++){
+        cfg.sched_wheel = m;
+        atomic_store(&sched_wakeups, 0);
+        take_timer_stats(&p50, &p99, &max);
+        struct rusage r0, r1;
+        getrusage(RUSAGE_SELF, &r0);
+        long moves = 0, elapsed = 0;
+        if(!run_bot_tables(cfg.tables, &moves, NULL, &elapsed)){
+            fprintf(stderr, "Error al preparar las mesas.\n");
+            return 1;
+        }
+        getrusage(RUSAGE_SELF, &r1);
+        take_timer_stats(&p50, &p99, &max);
+        printf("%-8s %10ld %10.0f %12.0f %9.1f %9.1f %9.1f %9ld %10ld\n", names[m], moves,
+               elapsed ? moves*1000.0/elapsed : 0.0, elapsed ? atomic_load(&sched_wakeups)*1000.0/elapsed : 0.0,
+               p50, p99, max, rusage_cpu_ms(&r1) - rusage_cpu_ms(&r0), r1.ru_nvcsw - r0.ru_nvcsw);
+    }
+
+    bench_timer_t *timers = calloc(n, sizeof(bench_timer_t));
+    pthread_t *threads = calloc(n, sizeof(pthread_t));
+    if(!timers || !threads){
+        free(timers); free(threads);
+        fprintf(stderr, "Sin memoria para los temporizadores.\n");
+        return 1;
+    }
+    printf("\n%d planificadores sintéticos, cuantum %d ms, %d ms\n", n, cfg.quantum_ms, WHEEL_BENCH_MS);
+    printf("%-8s %7s %12s %12s %9s %9s %9s %9s %10s\n", "planif", "hilos", "vencim/s", "despertar/s",
+           "p50 us", "p99 us", "máx us", "CPU ms", "ctx vol");
+    for(int m=first;m<=last;m++){
+        for(int i=0;i<n;i++){
+            timers[i] = (bench_timer_t){ .period_ms = cfg.quantum_ms, .phase_ms = 1 + i % cfg.quantum_ms };
+        }
+        atomic_store(&bench_timers_stop, 0);
+        atomic_store(&sched_wakeups, 0);
+        take_timer_stats(&p50, &p99, &max);
+        struct rusage r0, r1;
+        getrusage(RUSAGE_SELF, &r0);
+        long t0 = now_ms();
+        int started = 0;
+        for(int i=0;i<n;i++){
+            if(m) wheel_arm(&timers[i].timer, bench_timer_fire, &timers[i], timers[i].phase_ms);
+            else if(pthread_create(&threads[i], NULL, bench_sleeper_thread, &timers[i]) != 0) break;
+            started++;
+        }
+        msleep(WHEEL_BENCH_MS);
+        atomic_store(&bench_timers_stop, 1);
+        for(int i=0;i<started;i++){
+            if(m) wheel_wait_done(&timers[i].timer);
+            else pthread_join(threads[i], NULL);
+        }
+        long elapsed = now_ms() - t0;
+        getrusage(RUSAGE_SELF, &r1);
+        unsigned long fired = take_timer_stats(&p50, &p99, &max);
+        printf("%-8s %7d %12.0f %12.0f %9.1f %9.1f %9.1f %9ld %10ld\n", names[m], m ? 1 : started,
+               elapsed ? fired*1000.0/elapsed : 0.0, elapsed ? atomic_load(&sched_wakeups)*1000.0/elapsed : 0.0,
+               p50, p99, max, rusage_cpu_ms(&r1) - rusage_cpu_ms(&r0), r1.ru_nvcsw - r0.ru_nvcsw);
+    }
+    free(timers);
+    free(threads);
+    return 0;
+}
+
+// Memoria residente del proceso (0 si /proc no está disponible).
+static long resident_bytes(void){
+    FILE *f = fopen("/proc/self/statm", "r");
+    long pages = 0, resident = 0;
+    if(!f) return 0;
+    if(fscanf(f, "%ld %ld", &pages, &resident) != 2) resident = 0;
+    fclose(f);
+    return resident * sysconf(_SC_PAGESIZE);
+}
+
+// Prepara mesas de bots sin lanzar sus hilos y mide la memoria residente que
+// agregan, más un recorrido como el del panel (vista, pozo y manos de cada
+// mesa) para ver cuánto cuesta tocarlas todas.
+static int run_footprint_benchmark(void){
+    static const int COUNTS[] = { 1000, 100000 };
+    const int REPS = 5;
+    int seats = cfg.players ? cfg.players : 4; // peor caso del reparto aleatorio 2-4
+    size_t stack = 0;
+    pthread_attr_t attr;
+    pthread_attr_init(&attr);
+    pthread_attr_getstacksize(&attr, &stack);
+    pthread_attr_destroy(&attr);
+
+    size_t per_seat = sizeof(pcb_t) + sizeof(player_ctx_t) + sizeof(pthread_t);
+    size_t layout = sizeof(table_runtime_t) + seats*per_seat + sizeof(table_metrics_t);
+    printf("%s, %d jugadores por mesa\n", cfg.set->name, seats);
+    printf("ficha %zu B, jugada en cola %zu B, entrada de historial %zu B (%d en anillo)\n",
+           sizeof(tile_t), sizeof(move_t), sizeof(hist_move_t), HISTORY_CAP);
+    printf("game_state_t %zu B, table_runtime_t %zu B, por asiento %zu B, métricas %zu B, latencia compartida %zu B\n",
+           sizeof(game_state_t), sizeof(table_runtime_t), per_seat, sizeof(table_metrics_t),
+           sizeof(lat_hist_t)*LAT_STAGES*LAT_STRIPES);
+    printf("hilos por mesa al jugar: %d (pila reservada %zu KB cada uno, virtual)\n", seats + 2, stack/1024);
+    printf("%8s %12s %10s %10s %10s\n", "mesas", "RSS (KB)", "B/mesa", "estructura", "ns/mesa");
+    for(int c=0;c<(int)(sizeof(COUNTS)/sizeof(COUNTS[0]));c++){
+        int n = COUNTS[c];
+        long rss0 = resident_bytes();
+        table_runtime_t *tables = calloc(n, sizeof(table_runtime_t));
+        if(!tables || !metrics_init(n)){
+            fprintf(stderr, "Error al reservar memoria para %d mesas.\n", n);
+            free(tables);
+            return 1;
+        }
+        for(int t=0;t<n;t++){
+            tables[t].seats = seats;
+            if(!prepare_table(&tables[t], t, -1, 0, NULL)){
+                fprintf(stderr, "Error al preparar la mesa %d.\n", t+1);
+                return 1;
             }
+        }
+        long rss1 = resident_bytes();
+        size_t heap = (tables[0].state.store_len > D6_STORAGE) ? sizeof(tile_t)*(size_t)tables[0].state.store_len : 0;
 
-            int chosen_seat = -1;
-            if(occupy){
-                while(1){
-                    printf("Seleccione el número de asiento (1-%d): ", tbl->seats);
-                    fflush(stdout);
-                    if(scanf("%d", &chosen_seat) != 1){
-                        int ch;
-                        while((ch = getchar()) != '\n' && ch != EOF){}
-                        printf("Entrada inválida. Intente nuevamente.\n");
-                        chosen_seat = -1;
-                        continue;
-                    }
-                    chosen_seat -= 1;
-                    if(chosen_seat < 0 || chosen_seat >= tbl->seats){
-                        printf("Asiento fuera de rango. Intente nuevamente.\n");
-                        chosen_seat = -1;
-                    }else{
-                        break;
-                    }
+        long sink = 0;
+        long t0 = now_ns();
+        for(int r=0;r<REPS;r++){
+            for(int t=0;t<n;t++){
+                game_state_t *g = &tables[t].state;
+                table_view_t v = load_view(g);
+                sink += v.version + v.turn + pool_count(g);
+                for(int i=0;i<g->player_count;i++) sink += g->hand_len[i];
+            }
+        }
+        long elapsed = now_ns() - t0;
+        printf("%8d %12ld %10ld %10zu %10.1f\n", n, (rss1 - rss0)/1024, (rss1 - rss0)/n,
+               layout + heap, (double)elapsed/((long)REPS*n));
+        if(sink < 0) printf("\n"); // que el recorrido no se elimine
+
+        for(int t=0;t<n;t++) destroy_table(&tables[t]);
+        free(tables);
+        metrics_free();
+    }
+    return 0;
+}
+
+// Prepara --tables mesas de bots sin hilos, las juega hasta la mitad (unas 12
+// jugadas cada una), las guarda en path y las restaura desde el mapeo en otro
+// arreglo. Verifica que volver a serializar lo restaurado dé los mismos bytes.
+static int run_checkpoint_benchmark(const char *path){
+    int n = cfg.tables;
+    table_runtime_t *tables = calloc(n, sizeof(table_runtime_t));
+    table_runtime_t *restored = calloc(n, sizeof(table_runtime_t));
+    if(!tables || !restored){
+        fprintf(stderr, "Error al reservar memoria para %d mesas.\n", n);
+        return 1;
+    }
+    long moves = 0;
+    for(int t=0;t<n;t++){
+        tables[t].seats = cfg.players ? cfg.players : rand()%3 + 2;
+        if(!prepare_table(&tables[t], t, -1, 0, NULL)){
+            fprintf(stderr, "Error al preparar la mesa %d.\n", t+1);
+            return 1;
+        }
+        moves += play_headless(&tables[t].state, 12, NULL);
+    }
+
+    long t0 = now_ns();
+    long bytes = write_checkpoint(path, tables, n);
+    long write_ns = now_ns() - t0;
+    if(bytes < 0){
+        fprintf(stderr, "No se pudo escribir %s: %s\n", path, strerror(errno));
+        return 1;
+    }
+
+    t0 = now_ns();
+    size_t len = 0;
+    const ckpt_header_t *h = map_checkpoint(path, &len);
+    if(!h) return 1;
+    for(int t=0;t<n;t++){
+        const ckpt_table_t *rec = ckpt_record(h, t);
+        restored[t].seats = rec->seats;
+        if(!prepare_table(&restored[t], t, rec->human_seat, 0, rec)){
+            fprintf(stderr, "La mesa %d no se pudo restaurar.\n", t+1);
+            return 1;
+        }
+    }
+    long restore_ns = now_ns() - t0;
+
+    int mismatches = 0;
+    ckpt_table_t *again = malloc(h->record_size);
+    for(int t=0;t<n && again;t++){
+        memset(again, 0, h->record_size);
+        snapshot_table(&restored[t], again);
+        if(memcmp(again, ckpt_record(h, t), h->record_size) != 0) mismatches++;
+    }
+    free(again);
+
+    // Registros adulterados: --resume tiene que rechazar cada uno.
+    enum { TAMPER_PIP, TAMPER_DUP, TAMPER_END, TAMPER_WINNER, TAMPER_HISTORY, TAMPER_TABLE,
+           TAMPER_NO_TURN, TAMPER_NO_WINNER, TAMPER_COUNT };
+    static const char *const TAMPER_NAMES[TAMPER_COUNT] = { "pip fuera de rango", "ficha repetida",
+                                                            "extremo incoherente", "ganador inválido", "historial inválido",
+                                                            "mesa de otro índice", "partida en curso sin turno",
+                                                            "partida terminada sin ganador" };
+    int accepted = 0;
+    ckpt_table_t *bad = malloc(h->record_size);
+    for(int k=0;k<TAMPER_COUNT && bad;k++){
+        memcpy(bad, ckpt_record(h, 0), h->record_size);
+        switch(k){
+        case TAMPER_PIP:     bad->tiles[0].a = (int8_t)(cfg.set->max_pip + 1); break;
+        case TAMPER_DUP:     bad->tiles[1] = bad->tiles[0]; break;
+        case TAMPER_END:     bad->left_end = (int8_t)((bad->left_end + 1) % (cfg.set->max_pip + 1)); break;
+        case TAMPER_WINNER:  bad->winner = (int8_t)bad->seats; break;
+        case TAMPER_HISTORY: bad->history[0].player_id = bad->seats; bad->history_count |= 1; break;
+        case TAMPER_TABLE:   bad->table_id = 1; break;
+        case TAMPER_NO_TURN: bad->finished = 0; bad->turn = -1; bad->winner = -1; bad->blocked = 0; break;
+        case TAMPER_NO_WINNER: bad->finished = 1; bad->turn = -1; bad->winner = -1; break;
+        }
+        game_state_t scratch = {0};
+        if(restore_game_state(&scratch, cfg.set, bad, 0)){
+            fprintf(stderr, "Se aceptó un registro con %s.\n", TAMPER_NAMES[k]);
+            release_game_state(&scratch);
+            accepted++;
+        }
+    }
+    free(bad);
+    munmap((void*)h, len);
+
+    printf("%d mesas (%s), %ld jugadas previas, registro de %u B\n", n, cfg.set->name, moves, (unsigned)ckpt_record_size(cfg.set));
+    printf("%-10s %10s %10s %10s %10s\n", "fase", "KB", "ms", "MB/s", "us/mesa");
+    printf("%-10s %10ld %10.1f %10.1f %10.2f\n", "guardar", bytes/1024, write_ns/1e6,
+           write_ns ? bytes*1e3/write_ns : 0.0, write_ns/1e3/n);
+    printf("%-10s %10zu %10.1f %10.1f %10.2f\n", "restaurar", len/1024, restore_ns/1e6,
+           restore_ns ? len*1e3/restore_ns : 0.0, restore_ns/1e3/n);
+    printf("Verificación: %d de %d mesas difieren tras restaurar.\n", mismatches, n);
+    printf("Adulterados: %d de %d registros aceptados (deben ser 0).\n", accepted, TAMPER_COUNT);
+
+    for(int t=0;t<n;t++){
+        destroy_table(&tables[t]);
+        destroy_table(&restored[t]);
+    }
+    free(tables);
+    free(restored);
+    return (mismatches || accepted) ? 1 : 0;
+}
+
+/* ===== Análisis de manos iniciales ===== */
+// Cuánto decide el reparto: se juegan partidas de bots sin hilos, cada una con
+// su semilla (semilla base + número de partida, así el resultado no depende de
+// cuántos hilos haya), y cada asiento suma una partida (y una victoria si ganó)
+// en la cubeta de cada rasgo de su mano repartida. La mano de quien abrió
+// incluye la ficha de salida que setup_game_state ya puso en el tren.
+#define AF_VALUES 320   // pips de una mano de doble-doce: a lo sumo 12 fichas * 24
+#define ANALYSIS_CHUNK 1024
+typedef enum { AF_DOUBLES, AF_PIPS, AF_SUITS, AF_POSITION, AF_COUNT } hand_feature_t;
+static const char *const AF_NAMES[AF_COUNT] = { "dobles", "pips", "palos", "posicion" };
+
+typedef struct {
+    long games[AF_COUNT][AF_VALUES];
+    long wins[AF_COUNT][AF_VALUES];
+} analysis_tally_t;
+
+typedef struct {
+    int players;
+    uint64_t seed;
+    long games;
+    atomic_long *next;       // próxima partida sin reclamar (por bloques)
+    long moves;
+    analysis_tally_t tally;
+} analysis_worker_t;
+
+// Rasgos de cada mano en una pasada sin saltos: los palos presentes son un
+// bitmask (un bit por pip) y su cobertura, un popcount.
+static void hand_features(const game_state_t *g, int feat[MAX_PLAYERS][AF_COUNT]){
+    int n = g->player_count;
+    int opener = (g->turn - 1 + n) % n;
+    for(int seat=0;seat<n;seat++){
+        const tile_t *h = g->hands[seat];
+        int len = g->hand_len[seat];
+        unsigned suits = 0;
+        int doubles = 0, pips = 0;
+        for(int i=0;i<len;i++){
+            suits |= (1u << h[i].a) | (1u << h[i].b);
+            doubles += (h[i].a == h[i].b);
+            pips += h[i].a + h[i].b;
+        }
+        if(seat == opener){
+            tile_t t = g->train[0];
+            suits |= (1u << t.a) | (1u << t.b);
+            doubles += (t.a == t.b);
+            pips += t.a + t.b;
+        }
+        feat[seat][AF_DOUBLES] = doubles;
+        feat[seat][AF_PIPS] = pips < AF_VALUES ? pips : AF_VALUES - 1;
+        feat[seat][AF_SUITS] = __builtin_popcount(suits);
+        feat[seat][AF_POSITION] = (seat - opener + n) % n; // 0 = abrió
+    }
+}
+
+static void *analysis_thread(void *arg){
+    analysis_worker_t *w = (analysis_worker_t*)arg;
+    game_state_t *g = calloc(1, sizeof(game_state_t));
+    if(!g) return NULL;
+    init_game_locks(g);
+    int feat[MAX_PLAYERS][AF_COUNT];
+    while(1){
+        long start = atomic_fetch_add(w->next, ANALYSIS_CHUNK);
+        if(start >= w->games) break;
+        long end = (start + ANALYSIS_CHUNK < w->games) ? start + ANALYSIS_CHUNK : w->games;
+        for(long i=start;i<end;i++){
+            uint64_t rng = rng_seed(w->seed + (uint64_t)i);
+            if(!setup_game_state(g, cfg.set, 0, w->players, -1, &rng)) break;
+            hand_features(g, feat);
+            w->moves += play_headless_game(g);
+            for(int seat=0;seat<w->players;seat++){
+                int won = (seat == g->winner);
+                for(int f=0;f<AF_COUNT;f++){
+                    w->tally.games[f][feat[seat][f]]++;
+                    w->tally.wins[f][feat[seat][f]] += won;
                 }
             }
+        }
+    }
+    release_game_state(g);
+    destroy_game_locks(g);
+    free(g);
+    return NULL;
+}
 
-            tbl->pcbs = calloc(tbl->seats, sizeof(pcb_t));
-            tbl->pctx = calloc(tbl->seats, sizeof(player_ctx_t));
-            tbl->player_threads = calloc(tbl->seats, sizeof(pthread_t));
-            if(!tbl->pcbs || !tbl->pctx || !tbl->player_threads){
-                fprintf(stderr, "Error al reservar memoria para la mesa %d.\n", t+1);
-                return 1;
+// Raíz por Newton (sin libm); solo para los intervalos de confianza.
+static double sqrt_pos(double x){
+    if(x <= 0) return 0;
+    double r = x > 1 ? x : 1;
+    for(int i=0;i<64;i++){
+        double next = 0.5*(r + x/r);
+        if(next >= r) break;
+        r = next;
+    }
+    return r;
+}
+
+// Intervalo de Wilson al 95 % para wins/games.
+static void wilson_interval(long wins, long games, double *lo, double *hi){
+    const double z = 1.96;
+    double n = (double)games, p = wins/n;
+    double denom = 1 + z*z/n;
+    double center = (p + z*z/(2*n))/denom;
+    double half = z*sqrt_pos(p*(1-p)/n + z*z/(4*n*n))/denom;
+    *lo = center - half;
+    *hi = center + half;
+}
+
+static int run_hand_analysis(void){
+    int players = cfg.players ? cfg.players : 4;
+    if(players > cfg.set->max_players) players = cfg.set->max_players;
+    int threads = cfg.analyze_threads ? cfg.analyze_threads : (int)sysconf(_SC_NPROCESSORS_ONLN);
+    if(threads < 1) threads = 1;
+    uint64_t seed = (cfg.seed >= 0) ? (uint64_t)cfg.seed : (uint64_t)time(NULL);
+
+    analysis_worker_t *workers = calloc(threads, sizeof(analysis_worker_t));
+    pthread_t *tids = calloc(threads, sizeof(pthread_t));
+    if(!workers || !tids){
+        fprintf(stderr, "Error al reservar memoria para el análisis.\n");
+        return 1;
+    }
+    atomic_long next;
+    atomic_init(&next, 0);
+    long t0 = now_ns();
+    for(int i=0;i<threads;i++){
+        workers[i] = (analysis_worker_t){ .players = players, .seed = seed, .games = cfg.analyze_games, .next = &next };
+        pthread_create(&tids[i], NULL, analysis_thread, &workers[i]);
+    }
+    static analysis_tally_t total;
+    long moves = 0;
+    for(int i=0;i<threads;i++){
+        pthread_join(tids[i], NULL);
+        moves += workers[i].moves;
+        for(int f=0;f<AF_COUNT;f++){
+            for(int v=0;v<AF_VALUES;v++){
+                total.games[f][v] += workers[i].tally.games[f][v];
+                total.wins[f][v] += workers[i].tally.wins[f][v];
             }
+        }
+    }
+    double secs = (now_ns() - t0) / 1e9;
+    free(workers);
+    free(tids);
+
+    FILE *f = fopen(cfg.analyze_out, "w");
+    if(!f){
+        fprintf(stderr, "No se pudo escribir %s: %s\n", cfg.analyze_out, strerror(errno));
+        return 1;
+    }
+    fprintf(f, "juego,jugadores,rasgo,valor,manos,victorias,tasa,ic95_bajo,ic95_alto\n");
+    for(int ft=0;ft<AF_COUNT;ft++){
+        for(int v=0;v<AF_VALUES;v++){
+            long n = total.games[ft][v];
+            if(n == 0) continue;
+            double lo, hi;
+            wilson_interval(total.wins[ft][v], n, &lo, &hi);
+            fprintf(f, "%s,%d,%s,%d,%ld,%ld,%.5f,%.5f,%.5f\n", cfg.set->name, players, AF_NAMES[ft], v,
+                    n, total.wins[ft][v], (double)total.wins[ft][v]/n, lo, hi);
+        }
+    }
+    if(fclose(f) != 0){
+        fprintf(stderr, "No se pudo escribir %s.\n", cfg.analyze_out);
+        return 1;
+    }
 
-            tbl->state = (game_state_t){0};
-            pthread_mutex_init(&tbl->state.mtx, NULL);
-            setup_game_state(&tbl->state, t, tbl->seats, chosen_seat);
+    printf("%ld partidas de %s con %d jugadores (semilla %llu) en %.2f s con %d hilos: %.0f partidas/min, %.0f ns/partida por hilo\n",
+           cfg.analyze_games, cfg.set->name, players, (unsigned long long)seed, secs, threads,
+           secs > 0 ? cfg.analyze_games*60.0/secs : 0.0, secs*1e9*threads/cfg.analyze_games);
+    printf("Tasa base %.1f %% (1/%d). Rango de la tasa por rasgo, entre valores con al menos 1000 manos:\n",
+           100.0/players, players);
+    for(int ft=0;ft<AF_COUNT;ft++){
+        int lo_v = -1, hi_v = -1;
+        double lo_r = 2, hi_r = -1;
+        for(int v=0;v<AF_VALUES;v++){
+            long n = total.games[ft][v];
+            if(n < 1000) continue;
+            double r = (double)total.wins[ft][v]/n;
+            if(r < lo_r){ lo_r = r; lo_v = v; }
+            if(r > hi_r){ hi_r = r; hi_v = v; }
+        }
+        if(lo_v < 0) continue;
+        printf("  %-9s %5.1f %% (%s=%d) .. %5.1f %% (%s=%d)\n", AF_NAMES[ft],
+               100*lo_r, AF_NAMES[ft], lo_v, 100*hi_r, AF_NAMES[ft], hi_v);
+    }
+    printf("CSV: %s (%ld jugadas)\n", cfg.analyze_out, moves);
+    return 0;
+}
 
-            for(int i=0;i<tbl->seats;i++){
-                tbl->pcbs[i].pid=i;
-                tbl->pcbs[i].st=READY;
-                tbl->pcbs[i].pol=RR;
-                tbl->pcbs[i].can_run = 0;
-                pthread_mutex_init(&tbl->pcbs[i].mtx,NULL);
-                pthread_cond_init(&tbl->pcbs[i].run_cv,NULL);
-                tbl->pctx[i] = (player_ctx_t){ .id=i, .g=&tbl->state, .pcb=&tbl->pcbs[i], .is_human=(i==chosen_seat) };
-                pthread_create(&tbl->player_threads[i], NULL, player_thread, &tbl->pctx[i]);
+/* ===== Torneo de estrategias ===== */
+// Enfrenta las estrategias de --bots (por defecto todas) en partidas sin hilos
+// con semilla, en paralelo como el análisis. En la partida i el asiento s lo
+// juega lineup[(s + i) % k], así cada estrategia rota por todas las posiciones.
+typedef struct {
+    int players, lineup_count;
+    const bot_strategy_t *const *lineup;
+    uint64_t seed;
+    long games;
+    atomic_long *next;
+    long seats[MAX_PLAYERS], wins[MAX_PLAYERS];     // por índice en lineup
+    long decisions[MAX_PLAYERS], decide_ns[MAX_PLAYERS];
+} tourney_worker_t;
+
+static void *tourney_thread(void *arg){
+    tourney_worker_t *w = (tourney_worker_t*)arg;
+    game_state_t *g = calloc(1, sizeof(game_state_t));
+    if(!g) return NULL;
+    init_game_locks(g);
+    while(1){
+        long start = atomic_fetch_add(w->next, ANALYSIS_CHUNK);
+        if(start >= w->games) break;
+        long end = (start + ANALYSIS_CHUNK < w->games) ? start + ANALYSIS_CHUNK : w->games;
+        for(long i=start;i<end;i++){
+            uint64_t rng = rng_seed(w->seed + (uint64_t)i);
+            if(!setup_game_state(g, cfg.set, 0, w->players, -1, &rng)) break;
+            headless_bots_t hb = { .rng = rng };
+            for(int s=0;s<w->players;s++) hb.seats[s] = w->lineup[(s + i) % w->lineup_count];
+            play_headless(g, LONG_MAX, &hb);
+            for(int s=0;s<w->players;s++){
+                int li = (int)((s + i) % w->lineup_count);
+                w->seats[li]++;
+                w->wins[li] += (s == g->winner);
+                w->decisions[li] += hb.decisions[s];
+                w->decide_ns[li] += hb.decide_ns[s];
+            }
+        }
+    }
+    release_game_state(g);
+    destroy_game_locks(g);
+    free(g);
+    return NULL;
+}
+
+static int run_bot_tournament(void){
+    const bot_strategy_t *all[BOT_STRATEGY_COUNT];
+    const bot_strategy_t *const *lineup = cfg.bots;
+    int k = cfg.bot_count;
+    if(k == 0){
+        for(int i=0;i<BOT_STRATEGY_COUNT;i++) all[i] = &BOT_STRATEGIES[i];
+        lineup = all;
+        k = BOT_STRATEGY_COUNT;
+    }
+    int players = cfg.players ? cfg.players : k;
+    if(players < 2) players = 2;
+    if(players > cfg.set->max_players) players = cfg.set->max_players;
+    int threads = cfg.analyze_threads ? cfg.analyze_threads : (int)sysconf(_SC_NPROCESSORS_ONLN);
+    if(threads < 1) threads = 1;
+    uint64_t seed = (cfg.seed >= 0) ? (uint64_t)cfg.seed : (uint64_t)time(NULL);
+
+    tourney_worker_t *workers = calloc(threads, sizeof(tourney_worker_t));
+    pthread_t *tids = calloc(threads, sizeof(pthread_t));
+    if(!workers || !tids){
+        fprintf(stderr, "Error al reservar memoria para el torneo.\n");
+        return 1;
+    }
+    atomic_long next;
+    atomic_init(&next, 0);
+    long t0 = now_ns();
+    for(int i=0;i<threads;i++){
+        workers[i] = (tourney_worker_t){ .players = players, .lineup_count = k, .lineup = lineup,
+                                         .seed = seed, .games = cfg.bench_bots, .next = &next };
+        pthread_create(&tids[i], NULL, tourney_thread, &workers[i]);
+    }
+    long seats[MAX_PLAYERS] = {0}, wins[MAX_PLAYERS] = {0}, decisions[MAX_PLAYERS] = {0}, decide_ns[MAX_PLAYERS] = {0};
+    for(int i=0;i<threads;i++){
+        pthread_join(tids[i], NULL);
+        for(int l=0;l<k;l++){
+            seats[l] += workers[i].seats[l];
+            wins[l] += workers[i].wins[l];
+            decisions[l] += workers[i].decisions[l];
+            decide_ns[l] += workers[i].decide_ns[l];
+        }
+    }
+    double secs = (now_ns() - t0) / 1e9;
+    free(workers);
+    free(tids);
+
+    printf("%ld partidas de %s con %d jugadores (semilla %llu) en %.2f s con %d hilos: %.0f partidas/s\n",
+           cfg.bench_bots, cfg.set->name, players, (unsigned long long)seed, secs, threads,
+           secs > 0 ? cfg.bench_bots/secs : 0.0);
+    printf("%-12s %10s %10s %7s %17s %12s %12s\n", "estrategia", "asientos", "victorias", "tasa", "IC 95 %", "decisiones", "ns/decisión");
+    for(int l=0;l<k;l++){
+        if(seats[l] == 0) continue;
+        double lo, hi;
+        wilson_interval(wins[l], seats[l], &lo, &hi);
+        printf("%-12s %10ld %10ld %6.2f%% [%6.2f%%, %6.2f%%] %12ld %12.1f\n", lineup[l]->name, seats[l], wins[l],
+               100.0*wins[l]/seats[l], 100*lo, 100*hi, decisions[l], decisions[l] ? (double)decide_ns[l]/decisions[l] : 0.0);
+    }
+    return 0;
+}
+
+/* ===== Preparación de partidas ===== */
+// Pregunta cuántas mesas crear y si el usuario ocupa un asiento en cada una, y
+// las lanza. Devuelve 1 si quedaron en marcha, 0 si stdin se cerró y -1 ante
+// un error.
+static int setup_tables_interactive(table_runtime_t **out, int *out_count){
+    char line[LINE_LEN];
+    int tables_count = 0;
+    while(tables_count < 1){
+        printf("Ingrese la cantidad de mesas a crear (>=1): ");
+        fflush(stdout);
+        if(!read_line(line, sizeof(line))) return 0;
+        if(sscanf(line, "%d", &tables_count) != 1){
+            tables_count = 0;
+            printf("Entrada inválida. Intente nuevamente.\n");
+        }else if(tables_count < 1){
+            printf("La cantidad debe ser al menos 1.\n");
+        }
+    }
+
+    table_runtime_t *tables = calloc(tables_count, sizeof(table_runtime_t));
+    if(!tables){
+        fprintf(stderr, "Error al reservar memoria para las mesas.\n");
+        return -1;
+    }
+
+    if(!moveq_init(cfg.queue_cap, tables_count) || !metrics_init(tables_count)){
+        fprintf(stderr, "Error al reservar memoria para las métricas.\n");
+        return -1;
+    }
+
+    for(int t=0; t<tables_count; ++t){
+        table_runtime_t *tbl = &tables[t];
+        tbl->seats = cfg.players ? cfg.players : rand()%3 + 2;
+
+        printf("Mesa %d: %d asientos disponibles.\n", t+1, tbl->seats);
+        bool occupy = false;
+        char opt;
+        printf("¿Desea ocupar uno de estos asientos? (s/n): ");
+        fflush(stdout);
+        if(!read_line(line, sizeof(line))) return 0;
+        if(sscanf(line, " %c", &opt) == 1){
+            if(opt == 's' || opt == 'S'){
+                occupy = true;
+            }
+        }
+
+        int chosen_seat = -1;
+        if(occupy){
+            while(1){
+                printf("Seleccione el número de asiento (1-%d): ", tbl->seats);
+                fflush(stdout);
+                if(!read_line(line, sizeof(line))) return 0;
+                if(sscanf(line, "%d", &chosen_seat) != 1){
+                    printf("Entrada inválida. Intente nuevamente.\n");
+                    chosen_seat = -1;
+                    continue;
+                }
+                chosen_seat -= 1;
+                if(chosen_seat < 0 || chosen_seat >= tbl->seats){
+                    printf("Asiento fuera de rango. Intente nuevamente.\n");
+                    chosen_seat = -1;
+                }else{
+                    break;
+                }
             }
+        }
 
-            pthread_create(&tbl->validator_thread, NULL, validator_thread, &tbl->state);
+        if(!start_table(tbl, t, chosen_seat, 0)){
+            fprintf(stderr, "Error al preparar la mesa %d.\n", t+1);
+            return -1;
+        }
+    }
+    *out = tables;
+    *out_count = tables_count;
+    return 1;
+}
 
-            tbl->scheduler_ctx = (sched_ctx_t){ .pcbs=tbl->pcbs, .n=tbl->seats, .pol=RR, .quantum_ms=Q_DEFAULT_MS, .game=&tbl->state };
-            pthread_create(&tbl->scheduler_thread, NULL, scheduler_thread, &tbl->scheduler_ctx);
+// Reanuda todas las mesas de un checkpoint (ver map_checkpoint) y las lanza.
+// El juego, los asientos y el humano salen del archivo; los asientos remotos
+// del servidor vuelven como bots. Devuelve 1 o -1 como setup_tables_interactive.
+static int resume_tables(const char *path, table_runtime_t **out, int *out_count){
+    long t0 = now_ns();
+    size_t len = 0;
+    const ckpt_header_t *h = map_checkpoint(path, &len);
+    if(!h) return -1;
+    int tables_count = (int)h->table_count;
+    table_runtime_t *tables = calloc(tables_count, sizeof(table_runtime_t));
+    if(!tables || !moveq_init(cfg.queue_cap, tables_count) || !metrics_init(tables_count)){
+        fprintf(stderr, "Error al reservar memoria para las mesas.\n");
+        munmap((void*)h, len);
+        return -1;
+    }
+    for(int t=0;t<tables_count;t++){
+        const ckpt_table_t *rec = ckpt_record(h, t);
+        tables[t].seats = rec->seats;
+        if(!prepare_table(&tables[t], t, rec->human_seat, 0, rec)){
+            fprintf(stderr, "Checkpoint %s: la mesa %d es inconsistente.\n", path, t+1);
+            munmap((void*)h, len);
+            return -1;
         }
+    }
+    munmap((void*)h, len);
+    double ms = (now_ns() - t0) / 1e6;
+    for(int t=0;t<tables_count;t++) launch_table(&tables[t], t);
+    printf("Reanudadas %d mesas (%s) desde %s: %zu KB restaurados en %.1f ms.\n",
+           tables_count, cfg.set->name, path, len/1024, ms);
+    *out = tables;
+    *out_count = tables_count;
+    return 1;
+}
+
+/* ===== main ===== */
+int main(int argc, char **argv){
+    if(!parse_args(argc, argv)){
+        print_usage(argv[0]);
+        return 1;
+    }
+
+    srand((unsigned)time(NULL));
+    struct sigaction sa = { .sa_handler = on_latency_signal };
+    sigemptyset(&sa.sa_mask);
+    sa.sa_flags = SA_RESTART;
+    sigaction(SIGUSR1, &sa, NULL);
+    sa.sa_handler = on_checkpoint_signal;
+    sigaction(SIGUSR2, &sa, NULL);
+
+    if(cfg.bench_games > 0){
+        return run_set_benchmark(cfg.bench_games);
+    }
+    if(cfg.client_addr){
+        return run_load_client();
+    }
+    if(cfg.bench_affinity){
+        return run_affinity_benchmark();
+    }
+    if(cfg.bench_coro){
+        return run_exec_benchmark();
+    }
+    if(cfg.bench_wheel > 0){
+        return run_wheel_benchmark(cfg.bench_wheel);
+    }
+    if(cfg.bench_footprint){
+        return run_footprint_benchmark();
+    }
+    if(cfg.bench_checkpoint){
+        return run_checkpoint_benchmark(cfg.bench_checkpoint);
+    }
+    if(cfg.analyze_games > 0){
+        return run_hand_analysis();
+    }
+    if(cfg.bench_bots > 0){
+        return run_bot_tournament();
+    }
+    if(!placement_init(cfg.pin_mode, cfg.pin_group)){
+        fprintf(stderr, "No se pudo calcular la ubicación de hilos.\n");
+        return 1;
+    }
+    if(cfg.serve_addr){
+        return run_server();
+    }
+
+    char line[LINE_LEN];
+    int keep_playing = 1;
+    const char *resume = cfg.resume_path;
+    while(keep_playing){
+        table_runtime_t *tables = NULL;
+        int tables_count = 0;
+        int ready = resume ? resume_tables(resume, &tables, &tables_count)
+                           : setup_tables_interactive(&tables, &tables_count);
+        resume = NULL; // las partidas siguientes se preparan como siempre
+        if(ready <= 0) return ready < 0 ? 1 : 0;
 
         reporter_ctx_t rep_ctx = { .tables = tables, .table_count = tables_count, .interval_ms = 500 };
         pthread_t rep_thread;
         pthread_create(&rep_thread, NULL, reporter_thread, &rep_ctx);
 
+        input_ctx_t in_ctx = { .tables = tables, .table_count = tables_count };
+        atomic_init(&in_ctx.stop, 0);
+        pthread_t in_thread;
+        pthread_create(&in_thread, NULL, input_thread, &in_ctx);
+
         for(int t=0; t<tables_count; ++t){
-            table_runtime_t *tbl = &tables[t];
-            pthread_join(tbl->scheduler_thread, NULL);
-            pthread_join(tbl->validator_thread, NULL);
-            for(int i=0;i<tbl->seats;i++){
-                pthread_join(tbl->player_threads[i], NULL);
-            }
+            join_table(&tables[t]);
         }
 
         pthread_join(rep_thread, NULL);
+        atomic_store(&in_ctx.stop, 1);
+        pthread_join(in_thread, NULL);
 
         for(int t=0; t<tables_count; ++t){
-            table_runtime_t *tbl = &tables[t];
-            print_table_state(tbl, 1);
-            pthread_mutex_lock(&tbl->state.mtx);
-            int winner = tbl->state.winner;
-            int blocked = tbl->state.blocked;
-            int player_count = tbl->state.player_count;
-            int human_id = tbl->state.human_player;
-            int scores[MAX_PLAYERS] = {0};
-            for(int i=0;i<player_count;i++){
-                scores[i] = compute_hand_points(&tbl->state, i);
-            }
-            pthread_mutex_unlock(&tbl->state.mtx);
-            if(winner >= 0){
-                printf("Ganador mesa %d: Jugador %d%s (%s).\n", t+1, winner+1, (winner==human_id)?" (Humano)":"", blocked?"bloqueo":"mano limpia");
-            }else{
-                printf("Mesa %d finalizada sin ganador registrado.\n", t+1);
-            }
-            printf("Puntajes finales: ");
-            for(int i=0;i<player_count;i++){
-                printf("J%d=%d%s", i+1, scores[i], (i==player_count-1)?"":" | ");
-            }
-            printf("\n");
-
-            for(int i=0;i<tbl->seats;i++){
-                pthread_mutex_destroy(&tbl->pcbs[i].mtx);
-                pthread_cond_destroy(&tbl->pcbs[i].run_cv);
-            }
-            pthread_mutex_destroy(&tbl->state.mtx);
-            free(tbl->pcbs);
-            free(tbl->pctx);
-            free(tbl->player_threads);
+            // Con el panel no se vuelca cada mesa: solo el resultado.
+            if(!cfg.dashboard) print_table_state(&tables[t], 1);
+            report_table_result(&tables[t]);
+            if(!cfg.dashboard) print_quantum_report(&tables[t]);
+            destroy_table(&tables[t]);
         }
         free(tables);
-
-        int ch;
-        while((ch = getchar()) != '\n' && ch != EOF){}
+        print_validator_summary();
+        print_queue_summary();
+        print_latency_report();
+        metrics_free();
+        moveq_free();
 
         while(1){
             printf("\n¿Desea jugar otra partida? (s/n): ");
             fflush(stdout);
             char again;
-            if(scanf(" %c", &again) != 1){
-                while((ch = getchar()) != '\n' && ch != EOF){}
+            if(!read_line(line, sizeof(line))) return 0;
+            if(sscanf(line, " %c", &again) != 1){
                 printf("Entrada inválida.\n");
                 continue;
             }
             again = tolower((unsigned char)again);
-            while((ch = getchar()) != '\n' && ch != EOF){}
             if(again == 's'){
                 keep_playing = 1;
                 break;